@@ -0,0 +1,402 @@
+// Headless benchmark of the project loading stages, no window nor GL context is created and the GPU upload is skipped.
+// Results are printed as JSON on the standard output.
+//
+// Usage: LDtkViewerBench [--scale N]... [--repeat N] [project.ldtk]...
+// Without projects, all the projects of the res directory are used. Each project is also benchmarked with its
+// levels duplicated N times for each given scale (1, 4 and 16 by default).
+
+#include "Image.hpp"
+#include "LDtkProject/GeometryCache.hpp"
+#include "LDtkProject/JsonScanner.hpp"
+#include "LDtkProject/LDtkProject.hpp"
+#include "LDtkProject/LDtkProjectObjects.hpp"
+#include "LDtkProject/SearchIndex.hpp"
+#include "MappedFile.hpp"
+#include "Profiler.hpp"
+#include "TextureManager.hpp"
+#include "ThreadPool.hpp"
+
+#include <LDtkLoader/Project.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <new>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if !defined(LDTKVIEWER_RES_DIR)
+#define LDTKVIEWER_RES_DIR "res"
+#endif
+
+// Allocations made through operator new, memory allocated by C libraries with malloc is not counted
+namespace {
+    std::atomic<std::size_t> allocations_count{0};
+    std::atomic<std::size_t> allocated_bytes{0};
+}
+
+void* operator new(std::size_t size) {
+    allocations_count.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (auto* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Stage {
+        std::string name;
+        std::vector<double> wall_ms;
+        std::size_t allocations = 0;
+        std::size_t allocated_bytes = 0;
+        long peak_rss_kib = 0;
+    };
+
+    struct Result {
+        std::string file;
+        int scale = 1;
+        std::size_t levels = 0;
+        std::size_t layers = 0;
+        std::size_t tiles = 0;
+        std::vector<Stage> stages;
+        std::string error;
+    };
+
+    void measure(std::vector<Stage>& stages, std::size_t index, const char* name, const std::function<void()>& fn) {
+        if (stages.size() <= index)
+            stages.emplace_back().name = name;
+        auto& stage = stages[index];
+
+        Profiler::resetPeakMemory();
+        const auto allocations_start = allocations_count.load();
+        const auto bytes_start = allocated_bytes.load();
+        const auto start = Clock::now();
+        fn();
+        stage.wall_ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        // allocations and memory are the same for each run, only the first one is kept
+        if (stage.wall_ms.size() == 1) {
+            stage.allocations = allocations_count.load() - allocations_start;
+            stage.allocated_bytes = allocated_bytes.load() - bytes_start;
+            stage.peak_rss_kib = Profiler::getPeakMemoryKiB();
+        }
+    }
+
+    int toInt(std::string_view value) {
+        return value.empty() ? 0 : std::stoi(std::string(value));
+    }
+
+    std::string splice(const std::string& text, std::vector<std::pair<JsonScanner::Span, std::string>> replacements,
+                       std::size_t begin, std::size_t end) {
+        std::sort(replacements.begin(), replacements.end(), [](const auto& a, const auto& b) {
+            return a.first.begin < b.first.begin;
+        });
+        std::string result;
+        auto pos = begin;
+        for (const auto& [span, value] : replacements) {
+            result.append(text, pos, span.begin - pos);
+            result += value;
+            pos = span.end;
+        }
+        result.append(text, pos, end - pos);
+        return result;
+    }
+
+    // copies of all the levels of the project, placed on the right of the original ones
+    std::string scaleProject(const std::string& text, int scale) {
+        const JsonScanner scanner(text);
+        const auto uid_stride = toInt(scanner.view(scanner.member("nextUid")));
+
+        std::vector<JsonScanner::Span> arrays = {scanner.member("levels")};
+        for (const auto& world : scanner.elements(scanner.member("worlds")))
+            arrays.push_back(scanner.member("levels", world));
+
+        std::vector<std::pair<JsonScanner::Span, std::string>> replacements;
+        for (const auto& array : arrays) {
+            const auto levels = scanner.elements(array);
+            if (levels.empty())
+                continue;
+
+            auto min_x = INT_MAX;
+            auto max_x = INT_MIN;
+            for (const auto& level : levels) {
+                const auto x = toInt(scanner.view(scanner.member("worldX", level)));
+                min_x = std::min(min_x, x);
+                max_x = std::max(max_x, x + toInt(scanner.view(scanner.member("pxWid", level))));
+            }
+
+            std::string result = "[";
+            for (int copy = 0; copy < scale; ++copy) {
+                for (const auto& level : levels) {
+                    if (result.size() > 1)
+                        result += ',';
+                    if (copy == 0) {
+                        result += scanner.view(level);
+                        continue;
+                    }
+                    const auto suffix = "_" + std::to_string(copy);
+                    const auto identifier = scanner.member("identifier", level);
+                    const auto iid = scanner.member("iid", level);
+                    const auto uid = scanner.member("uid", level);
+                    const auto world_x = scanner.member("worldX", level);
+                    result += splice(text, {
+                        {identifier, "\"" + scanner.string(identifier) + suffix + "\""},
+                        {iid, "\"" + scanner.string(iid) + suffix + "\""},
+                        {uid, std::to_string(toInt(scanner.view(uid)) + uid_stride * copy)},
+                        {world_x, std::to_string(toInt(scanner.view(world_x)) + (max_x - min_x) * copy)},
+                    }, level.begin, level.end);
+                }
+            }
+            result += "]";
+            replacements.emplace_back(array, std::move(result));
+        }
+        return splice(text, std::move(replacements), 0, text.size());
+    }
+
+    void run(Result& result, const std::string& path, int repeat) {
+        auto& pool = ThreadPool::global();
+        for (int i = 0; i < repeat; ++i) {
+            std::unique_ptr<ldtk::Project> project;
+            std::unique_ptr<LDtkProjectObjects> objects;
+            std::vector<const LDtkProjectObjects::Level*> levels;
+            std::set<std::string> textures;
+
+            measure(result.stages, 0, "parse", [&] {
+                project = std::make_unique<ldtk::Project>();
+                project->loadFromFile(path);
+            });
+            measure(result.stages, 1, "build", [&] {
+                objects = std::make_unique<LDtkProjectObjects>();
+                for (const auto& world : project->allWorlds())
+                    objects->worlds.emplace_back(world, path, pool);
+            });
+
+            result.layers = 0;
+            result.tiles = 0;
+            for (const auto& world : objects->worlds) {
+                for (const auto& [_, depth_levels] : world.levels) {
+                    for (const auto& level : depth_levels) {
+                        levels.push_back(&level);
+                        for (const auto& layer : level.layers) {
+                            result.layers++;
+                            result.tiles += layer.data.allTiles().size();
+                            if (!layer.texture_path.empty())
+                                textures.insert(layer.texture_path);
+                        }
+                    }
+                }
+            }
+            result.levels = levels.size();
+
+            measure(result.stages, 2, "geometry", [&] {
+                pool.parallelFor(levels.size(), [&](std::size_t index) {
+                    levels[index]->buildGeometry(true, true);
+                });
+            });
+            // what TextureManager decodes before uploading, one image at a time (decode_parallel below)
+            measure(result.stages, 3, "decode", [&] {
+                for (const auto& texture : textures) {
+                    Image image;
+                    if (!image.load(texture))
+                        std::fprintf(stderr, "Failed to load Image %s\n", texture.c_str());
+                }
+            });
+
+            objects.reset();
+            project.reset();
+
+            // the whole loading, as done by the viewer before the upload
+            measure(result.stages, 4, "load", [&] {
+                LDtkProject viewer_project;
+                viewer_project.use_geometry_cache = false;
+                if (!viewer_project.loadData(path.c_str()))
+                    throw std::runtime_error("Failed to load " + path);
+            });
+
+            // the geometry of the levels built as the viewer does when they become visible, with a geometry
+            // cache missing every level (built and written), then with the files written, to compare with "geometry"
+            const auto cache_directory = (std::filesystem::temp_directory_path() / "LDtkViewerBench").string();
+            std::filesystem::remove_all(cache_directory);
+            const auto geometry_with_cache = [&](int stage, const char* name) {
+                LDtkProject viewer_project;
+                viewer_project.use_geometry_cache = false;
+                if (!viewer_project.loadData(path.c_str()))
+                    throw std::runtime_error("Failed to load " + path);
+                GeometryCache cache(cache_directory, GeometryCache::keyOf(*viewer_project.data, LDtkProjectObjects::directoryOf(path)));
+                std::vector<const LDtkProjectObjects::Level*> cached_levels;
+                for (auto& world : viewer_project.objects->worlds) {
+                    for (auto& [_, depth_levels] : world.levels) {
+                        for (auto& level : depth_levels) {
+                            if (level.content_hash != 0)
+                                level.geometry_cache = &cache;
+                            cached_levels.push_back(&level);
+                        }
+                    }
+                }
+                measure(result.stages, stage, name, [&] {
+                    pool.parallelFor(cached_levels.size(), [&](std::size_t index) {
+                        cached_levels[index]->buildGeometry(true, true);
+                    });
+                });
+            };
+            geometry_with_cache(5, "geometry_cache_miss");
+            geometry_with_cache(6, "geometry_cache_hit");
+            std::filesystem::remove_all(cache_directory);
+            // the reading as done by the viewer, the mapping of the file is scanned and released before the parsing
+            measure(result.stages, 7, "ingest", [&] {
+                MappedFile file;
+                if (!file.open(path, true))
+                    throw std::runtime_error("Failed to open " + path);
+                const JsonScanner scanner(file.view());
+                for (const auto& level : scanner.elements(scanner.member("levels")))
+                    scanner.view(scanner.member("layerInstances", level));
+                file.close();
+                ldtk::Project ingested;
+                ingested.loadFromFile(path);
+            });
+            // the decoding as done by the viewer, on the pool threads
+            measure(result.stages, 8, "decode_parallel", [&] {
+                std::map<std::string, Image> images;
+                for (const auto& texture : textures)
+                    images[texture];
+                TextureManager::prefetch(images, pool);
+            });
+
+            // the search index of a loaded project, then the queries typed to find its last entity
+            LDtkProject indexed;
+            indexed.use_geometry_cache = false;
+            if (!indexed.loadData(path.c_str()))
+                throw std::runtime_error("Failed to load " + path);
+            std::unique_ptr<SearchIndex> index;
+            measure(result.stages, 9, "index", [&] {
+                index = std::make_unique<SearchIndex>(*indexed.objects);
+            });
+            std::string name;
+            for (const auto& world : indexed.objects->worlds) {
+                for (const auto& [_, depth_levels] : world.levels) {
+                    for (const auto& level : depth_levels)
+                        name = level.entities.empty() ? level.data.name : level.entities.back()->data.getName();
+                }
+            }
+            measure(result.stages, 10, "search", [&] {
+                std::vector<SearchIndex::Document> documents;
+                for (std::size_t length = 1; length <= name.size(); ++length)
+                    index->query(std::string_view(name).substr(0, length), documents, LDtkProject::max_search_results);
+            });
+        }
+    }
+
+    std::string escape(const std::string& value) {
+        std::string result;
+        for (const auto c : value) {
+            if (c == '"' || c == '\\')
+                result += '\\';
+            if (static_cast<unsigned char>(c) < 0x20)
+                result += ' ';
+            else
+                result += c;
+        }
+        return result;
+    }
+
+    void print(const std::vector<Result>& results, int repeat) {
+        std::printf("{\n  \"threads\": %u,\n  \"repeat\": %d,\n  \"results\": [", ThreadPool::global().getThreadsCount(), repeat);
+        for (std::size_t r = 0; r < results.size(); ++r) {
+            const auto& result = results[r];
+            std::printf("%s\n    {\"file\": \"%s\", \"scale\": %d, \"levels\": %zu, \"layers\": %zu, \"tiles\": %zu",
+                        r == 0 ? "" : ",", escape(result.file).c_str(), result.scale, result.levels, result.layers, result.tiles);
+            if (!result.error.empty())
+                std::printf(", \"error\": \"%s\"", escape(result.error).c_str());
+            std::printf(", \"stages\": [");
+            for (std::size_t s = 0; s < result.stages.size(); ++s) {
+                const auto& stage = result.stages[s];
+                if (stage.wall_ms.empty())
+                    continue;
+                auto sorted = stage.wall_ms;
+                std::sort(sorted.begin(), sorted.end());
+                std::printf("%s\n      {\"name\": \"%s\", \"wall_ms\": %.3f, \"wall_ms_min\": %.3f, \"allocations\": %zu, "
+                            "\"allocated_bytes\": %zu, \"peak_rss_kib\": %ld}",
+                            s == 0 ? "" : ",", stage.name.c_str(), sorted[sorted.size() / 2], sorted.front(),
+                            stage.allocations, stage.allocated_bytes, stage.peak_rss_kib);
+            }
+            std::printf("\n    ]}");
+        }
+        std::printf("\n  ]\n}\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> files;
+    std::vector<int> scales;
+    auto repeat = 1;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--scale" && i + 1 < argc)
+            scales.push_back(std::max(1, std::atoi(argv[++i])));
+        else if (arg == "--repeat" && i + 1 < argc)
+            repeat = std::max(1, std::atoi(argv[++i]));
+        else
+            files.push_back(arg);
+    }
+    if (scales.empty())
+        scales = {1, 4, 16};
+    if (files.empty()) {
+        for (const auto& entry : std::filesystem::directory_iterator(LDTKVIEWER_RES_DIR)) {
+            if (entry.path().extension() == ".ldtk")
+                files.push_back(entry.path().generic_string());
+        }
+        std::sort(files.begin(), files.end());
+    }
+
+    std::vector<Result> results;
+    for (const auto& file : files) {
+        std::string text;
+        if (std::ifstream in{file, std::ios::binary})
+            text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+        for (const auto scale : scales) {
+            auto& result = results.emplace_back();
+            result.file = file;
+            result.scale = scale;
+            // scaled projects are written next to the original, so that the tilesets paths stay valid
+            auto path = file;
+            if (scale > 1) {
+                const auto original = std::filesystem::path(file);
+                path = (original.parent_path() / (original.stem().string() + ".bench-x" + std::to_string(scale) + ".ldtk")).generic_string();
+                std::ofstream(path, std::ios::binary) << scaleProject(text, scale);
+            }
+            try {
+                run(result, path, repeat);
+            } catch (std::exception& ex) {
+                result.error = ex.what();
+            }
+            if (scale > 1)
+                std::filesystem::remove(path);
+        }
+    }
+
+    print(results, repeat);
+    return 0;
+}
@@ -2,41 +2,274 @@
 
 #include "App.hpp"
 #include "Config.hpp"
+#include "Image.hpp"
 
 #include "LDtkProject/ldtk2glm.hpp"
+#include "Profiler.hpp"
+#include "TextureManager.hpp"
+#include "ThreadPool.hpp"
 
 #include <LDtkLoader/World.hpp>
 
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
 #include <filesystem>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <unordered_map>
 
 constexpr auto WINDOW_WIDTH = 1366;
 constexpr auto WINDOW_HEIGHT = 768;
 constexpr auto WINDOW_TITLE = "LDtk Viewer";
 
+// GPU memory kept for the geometry of the most recently visible levels
+constexpr auto LEVEL_CACHE_BUDGET = std::size_t(256) * 1024 * 1024;
+constexpr auto TEXTURES_BUDGET = std::size_t(512) * 1024 * 1024;
+
+// levels of streamed projects are requested when they are closer to the view than this fraction of its size
+constexpr auto STREAMING_MARGIN = 0.5f;
+
+// impostors rendered per frame when zooming out, the other levels are drawn with their layers meanwhile
+constexpr auto IMPOSTOR_BUILDS_PER_FRAME = 8;
+
+// frames drawn after an event in redraw on demand mode, ImGui needs a few frames to settle its hover states
+constexpr auto REDRAW_FRAMES = 3;
+// longest wait for events when idle, so that watched files and background loads are still polled
+constexpr auto IDLE_WAIT_TIMEOUT = 0.1;
+// the stats panel is refreshed this often when idle
+constexpr auto STATS_REFRESH_PERIOD = std::chrono::milliseconds(250);
+
+// mouse moves shorter than this between press and release are considered clicks
+constexpr auto CLICK_MAX_DISTANCE = 4;
+
+#if defined(EMSCRIPTEN)
+// no worker threads on the web, projects are loaded when polled
+constexpr auto LOADING_POLICY = std::launch::deferred;
+#else
+constexpr auto LOADING_POLICY = std::launch::async;
+#endif
+
+static const glm::vec2 VIEW_OFFSET = {layout::left_panel_width, layout::tabs_bar_height};
+
 App::App() :
 m_window(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE),
-m_imgui(*this) {
+m_imgui(*this),
+m_level_cache(LEVEL_CACHE_BUDGET) {
     m_shader.load(vert_shader, frag_shader);
+    TextureManager::setBudget(TEXTURES_BUDGET);
 }
 
-bool App::loadLDtkFile(const char* path) {
-    if (m_projects.count(path) > 0) {
-        unloadLDtkFile(path);
-    }
-    m_projects.emplace(path, LDtkProject{});
-    if (m_projects.at(path).load(path)) {
-        m_projects.at(path).camera.setSize(m_window.getSize());
-        m_selected_project = &m_projects.at(path);
-        return true;
-    } else {
-        m_projects.erase(path);
+bool App::loadLDtkFile(const char* path, bool reuse_textures) {
+    if (m_loading_projects.count(path) > 0) {
         return false;
     }
+    auto& loading = m_loading_projects[path];
+    loading.project = std::make_unique<LDtkProject>();
+    if (const auto previous = m_projects.find(path); previous != m_projects.end()) {
+        // a project reloaded on change is being written by the editor, it is read rather than mapped
+        loading.project->map_file = false;
+        if (reuse_textures)
+            loading.project->reuseTextures(previous->second);
+    }
+    loading.progress = std::make_shared<std::atomic<float>>(0.f);
+    loading.result = std::async(LOADING_POLICY, [project = loading.project.get(), progress = loading.progress, filepath = std::string(path)] {
+        return project->loadData(filepath.c_str(), [&progress](float value) { progress->store(value); });
+    });
+    return true;
+}
+
+void App::finishLoadingProjects() {
+    for (auto it = m_loading_projects.begin(); it != m_loading_projects.end();) {
+        auto& [path, loading] = *it;
+        if (loading.result.wait_for(std::chrono::seconds(0)) == std::future_status::timeout) {
+            ++it;
+            continue;
+        }
+        if (loading.result.get()) {
+            loading.project->upload();
+            loading.project->camera.setSize(m_window.getSize());
+            if (const auto previous = m_projects.find(path); previous != m_projects.end()) {
+                // replaced in place, so that the selected project stays the same
+                reuseProject(previous->second, *loading.project);
+                previous->second = std::move(*loading.project);
+            } else {
+                m_selected_project = &m_projects.emplace(path, std::move(*loading.project)).first->second;
+            }
+            watchProject(m_projects.at(path));
+        }
+        requestRedraw();
+        it = m_loading_projects.erase(it);
+    }
+}
+
+void App::streamLevels() {
+    std::size_t definitions = 0;
+    for (auto& [_, project] : m_projects) {
+        if (project.streamer == nullptr)
+            continue;
+        // the levels are built again with their layers the next time they are drawn
+        const auto& updated = project.streamer->poll();
+        definitions += project.streamer->getProjectsCount() * project.streamer->getHeaderSize();
+        for (const auto* level : updated)
+            m_level_cache.invalidate(*level);
+        if (updated.empty())
+            continue;
+        // their entities are searchable once loaded
+        if (project.search_index != nullptr) {
+            project.search_index->add(updated);
+            project.search();
+        }
+        requestRedraw();
+    }
+    m_level_cache.setPinnedMemory(definitions);
+}
+
+void App::reuseProject(LDtkProject& previous, LDtkProject& project) {
+    // pending levels loads of the previous objects are cancelled
+    previous.streamer.reset();
+    project.camera = previous.camera;
+    project.depth = previous.depth;
+    project.render_entities = previous.render_entities;
+    project.render_intgrid = previous.render_intgrid;
+
+    auto renderer = [&](auto& renderers) {
+        const auto it = renderers.find(project.path);
+        return it != renderers.end() ? it->second.get() : nullptr;
+    };
+    auto* instanced = renderer(m_instanced_renderers);
+    auto* intgrid = renderer(m_intgrid_renderers);
+    auto* tilemap = renderer(m_tilemap_renderers);
+    auto* impostors = renderer(m_impostor_renderers);
+
+    std::unordered_map<std::string, LDtkProjectObjects::Level*> previous_levels;
+    for (auto& world : previous.objects->worlds)
+        for (auto& [_, depth_levels] : world.levels)
+            for (auto& level : depth_levels)
+                previous_levels[level.data.iid.str()] = &level;
+
+    // levels are matched by iid, the GPU data of the layers whose JSON didn't change is kept
+    for (auto& world : project.objects->worlds) {
+        for (auto& [_, depth_levels] : world.levels) {
+            for (auto& level : depth_levels) {
+                const auto it = previous_levels.find(level.data.iid.str());
+                if (it == previous_levels.end() || level.content_hash == 0 || it->second->layers.size() != level.layers.size()
+                    || it->second->bounds.pos.x != level.bounds.pos.x || it->second->bounds.pos.y != level.bounds.pos.y)
+                    continue;
+                auto& previous_level = *it->second;
+                std::size_t layers_kept = 0;
+                for (std::size_t i = 0; i < level.layers.size(); ++i) {
+                    auto& layer = level.layers[i];
+                    auto& previous_layer = previous_level.layers[i];
+                    if (layer.content_hash != previous_layer.content_hash) {
+                        // tilemaps of the same size are updated in place
+                        if (tilemap != nullptr) {
+                            tilemap->transfer(previous_layer, layer);
+                            tilemap->update(layer);
+                        }
+                        continue;
+                    }
+                    layer.takeGeometry(previous_layer);
+                    if (instanced != nullptr)
+                        instanced->transfer(previous_layer, layer);
+                    if (intgrid != nullptr)
+                        intgrid->transfer(previous_layer, layer);
+                    if (tilemap != nullptr)
+                        tilemap->transfer(previous_layer, layer);
+                    layers_kept++;
+                }
+                if (level.content_hash == previous_level.content_hash && layers_kept == level.layers.size()) {
+                    if (impostors != nullptr)
+                        impostors->transfer(previous_level, level);
+                    m_level_cache.transfer(previous_level, level);
+                }
+            }
+        }
+    }
+
+    // what wasn't moved to the new levels belongs to levels that changed or were removed
+    m_level_cache.forget(*previous.objects);
+    // the batches reference the previous objects
+    m_batch_renderers.erase(project.path);
+
+    // selection is kept through the iids, the levels may have moved or changed
+    if (previous.selected_world != nullptr) {
+        if (const auto* location = project.objects->findIid(previous.selected_world->data.iid.str()))
+            project.selected_world = location->world;
+    }
+    if (previous.selected_level != nullptr) {
+        if (const auto* location = project.objects->findIid(previous.selected_level->data.iid.str()))
+            project.selected_level = location->level;
+    }
+    if (previous.selected_entity != nullptr && project.selected_level != nullptr) {
+        const auto* location = project.objects->findIid(previous.selected_entity->data.iid.str());
+        if (location != nullptr && location->level == project.selected_level)
+            project.selected_entity = location->entity;
+    }
+    if (previous.selected_field != nullptr && project.selected_entity != nullptr) {
+        for (const auto& field : project.selected_entity->fields) {
+            if (field.data.name == previous.selected_field->data.name) {
+                project.selected_field = &field;
+            }
+        }
+    }
+    project.search_text = previous.search_text;
+    project.search();
+}
+
+void App::watchProject(const LDtkProject& project) {
+    m_watcher.unwatch(project.path);
+    m_watcher.watch(project.path, project.path);
+    for (const auto& level_file : project.levels_files)
+        m_watcher.watch(project.path, level_file);
+    for (const auto& texture : project.textures)
+        m_watcher.watch(project.path, texture.getName());
+}
+
+void App::reloadChangedFiles() {
+    std::set<std::string> reloaded_textures;
+    for (const auto& change : m_watcher.poll()) {
+        // the levels files are part of the project
+        if (change.path == change.owner || std::filesystem::path(change.path).extension() == ".ldtkl") {
+            m_pending_reloads.insert(change.owner);
+            continue;
+        }
+        // tilesets are decoded again and replace the content of their texture
+        if (reloaded_textures.insert(change.path).second) {
+            Image image;
+            if (image.load(change.path))
+                TextureManager::load(change.path, image);
+            else
+                std::cerr << "Failed to load Image " << change.path << std::endl;
+        }
+        // the batches and impostors hold copies of the tilesets
+        requestRedraw();
+        m_batch_renderers.erase(change.owner);
+        if (const auto impostors = m_impostor_renderers.find(change.owner); impostors != m_impostor_renderers.end())
+            impostors->second->clear();
+    }
+    // projects already being loaded are reloaded once done
+    for (auto it = m_pending_reloads.begin(); it != m_pending_reloads.end();) {
+        if (m_projects.count(*it) == 0 || loadLDtkFile(it->c_str(), true))
+            it = m_pending_reloads.erase(it);
+        else
+            ++it;
+    }
 }
 
 void App::unloadLDtkFile(const char* path) {
     if (m_projects.count(path)) {
+        m_watcher.unwatch(path);
         const auto selected_path = m_selected_project->path;
+        m_batch_renderers.erase(path);
+        m_instanced_renderers.erase(path);
+        m_intgrid_renderers.erase(path);
+        m_tilemap_renderers.erase(path);
+        m_impostor_renderers.erase(path);
+        m_level_cache.forget(*m_projects.at(path).objects);
         m_projects.erase(path);
         if (!m_projects.empty()) {
             if (selected_path == path)
@@ -50,20 +283,50 @@ void App::unloadLDtkFile(const char* path) {
 void App::run() {
 #if !defined(EMSCRIPTEN)
     while (m_window.isOpen()) {
-        while (auto event = m_window.nextEvent()) {
-            processEvent(event.value());
+        if (m_redraw_on_demand && !redrawPending())
+            glfwWaitEventsTimeout(IDLE_WAIT_TIMEOUT);
+        const auto frame_start = std::chrono::steady_clock::now();
+        Profiler::beginFrame();
+        {
+            Profiler::Scope scope("events");
+            while (auto event = m_window.nextEvent()) {
+                processEvent(event.value());
+            }
+            reloadChangedFiles();
+            finishLoadingProjects();
+            streamLevels();
         }
+        // the frame is not ended, its record is reused by the next one
+        const auto redraw = shouldRedraw();
+        updateCpuUsage(redraw);
+        if (!redraw)
+            continue;
 
-        if (projectOpened()) {
-            m_window.clear(ldtk2glm(getActiveProject().data->getBgColor()));
-            renderActiveProject();
-        } else {
-            m_window.clear({54.f/255.f, 60.f/255.f, 69.f/255.f});
+        {
+            Profiler::Scope scope("render");
+            if (projectOpened()) {
+                m_window.clear(ldtk2glm(getActiveProject().data->getBgColor()));
+                Profiler::beginGpu();
+                renderActiveProject();
+                Profiler::endGpu();
+            } else {
+                m_window.clear({54.f/255.f, 60.f/255.f, 69.f/255.f});
+            }
         }
 
-        m_imgui.render();
+        {
+            Profiler::Scope scope("imgui");
+            m_imgui.render();
+        }
 
-        m_window.display();
+        {
+            Profiler::Scope scope("display");
+            m_window.display();
+        }
+        Profiler::endFrame();
+        frameDrawn();
+        if (m_frame_cap > 0)
+            std::this_thread::sleep_until(frame_start + std::chrono::microseconds(1000000 / m_frame_cap));
     }
 #else
     struct AppContext {
@@ -72,17 +335,40 @@ void App::run() {
     auto ctx = AppContext{*this};
     auto main_loop = [](void* arg) {
         auto* ctx = static_cast<AppContext*>(arg);
-        while (auto event = ctx->app.m_window.nextEvent()) {
-            ctx->app.processEvent(event.value());
+        Profiler::beginFrame();
+        {
+            Profiler::Scope scope("events");
+            while (auto event = ctx->app.m_window.nextEvent()) {
+                ctx->app.processEvent(event.value());
+            }
+            ctx->app.reloadChangedFiles();
+            ctx->app.finishLoadingProjects();
+            ctx->app.streamLevels();
         }
-        if (ctx->app.projectOpened()) {
-            ctx->app.m_window.clear(ldtk2glm(ctx->app.getActiveProject().data->getBgColor()));
-            ctx->app.renderActiveProject();
-        } else {
-            ctx->app.m_window.clear({54.f/255.f, 60.f/255.f, 69.f/255.f});
+        // the canvas keeps its content when nothing is drawn during an animation frame
+        const auto redraw = ctx->app.shouldRedraw();
+        ctx->app.updateCpuUsage(redraw);
+        if (!redraw)
+            return;
+        {
+            Profiler::Scope scope("render");
+            if (ctx->app.projectOpened()) {
+                ctx->app.m_window.clear(ldtk2glm(ctx->app.getActiveProject().data->getBgColor()));
+                ctx->app.renderActiveProject();
+            } else {
+                ctx->app.m_window.clear({54.f/255.f, 60.f/255.f, 69.f/255.f});
+            }
+        }
+        {
+            Profiler::Scope scope("imgui");
+            ctx->app.m_imgui.render();
+        }
+        {
+            Profiler::Scope scope("display");
+            ctx->app.m_window.display();
         }
-        ctx->app.m_imgui.render();
-        ctx->app.m_window.display();
+        Profiler::endFrame();
+        ctx->app.frameDrawn();
     };
     emscripten_set_main_loop_arg(main_loop, &ctx, 0, EM_TRUE);
 #endif
@@ -96,18 +382,17 @@ auto App::allProjects() -> std::map<std::string, LDtkProject>& {
     return m_projects;
 }
 
+auto App::loadingProjects() const -> const std::map<std::string, LoadingProject>& {
+    return m_loading_projects;
+}
+
 bool App::projectOpened() {
     return m_selected_project != nullptr;
 }
 
 void App::refreshActiveProject() {
-    const auto path = m_selected_project->path;
-    const auto cam = getCamera();
-    const auto depth = getActiveProject().depth;
-    unloadLDtkFile(path.c_str());
-    loadLDtkFile(path.c_str());
-    getCamera() = cam;
-    getActiveProject().depth = depth;
+    // the current project stays displayed until its reloaded version is ready
+    loadLDtkFile(m_selected_project->path.c_str());
 }
 
 LDtkProject& App::getActiveProject() {
@@ -122,9 +407,117 @@ Camera2D& App::getCamera() {
     return m_selected_project->camera;
 }
 
+auto App::getRenderStats() const -> const RenderStats& {
+    return m_render_stats;
+}
+
+bool App::statsVisible() const {
+    return m_show_stats;
+}
+
+void App::requestRedraw() {
+    m_redraw_frames = REDRAW_FRAMES;
+}
+
+bool App::redrawPending() const {
+    if (m_redraw_frames > 0 || m_render_incomplete || !m_loading_projects.empty())
+        return true;
+    // levels entering the view while they load
+    return std::any_of(m_projects.begin(), m_projects.end(), [](const auto& project) {
+        return project.second.streamer != nullptr && project.second.streamer->getPendingCount() > 0;
+    });
+}
+
+bool App::shouldRedraw() const {
+    if (!m_redraw_on_demand || redrawPending())
+        return true;
+    return m_show_stats && std::chrono::steady_clock::now() - m_last_draw >= STATS_REFRESH_PERIOD;
+}
+
+void App::frameDrawn() {
+    m_last_draw = std::chrono::steady_clock::now();
+    if (m_redraw_frames > 0)
+        m_redraw_frames--;
+}
+
+void App::updateCpuUsage(bool drawn) {
+    // process time of all the threads, relative to one core
+    const auto now = std::chrono::steady_clock::now();
+    const auto clock = std::clock();
+    if (drawn)
+        m_cpu_frames++;
+    const auto elapsed = std::chrono::duration<double>(now - m_cpu_start).count();
+    if (elapsed < 1.)
+        return;
+    const auto usage = static_cast<float>(static_cast<double>(clock - m_cpu_clock) / CLOCKS_PER_SEC / elapsed * 100.);
+    (m_cpu_frames > 0 ? m_cpu_active : m_cpu_idle) = usage;
+    m_cpu_start = now;
+    m_cpu_clock = clock;
+    m_cpu_frames = 0;
+}
+
+float App::getCpuUsage(bool idle) const {
+    return idle ? m_cpu_idle : m_cpu_active;
+}
+
+bool App::redrawOnDemand() const {
+    return m_redraw_on_demand;
+}
+
+void App::setRedrawOnDemand(bool on_demand) {
+    m_redraw_on_demand = on_demand;
+}
+
+int App::getFrameCap() const {
+    return m_frame_cap;
+}
+
+void App::setFrameCap(int fps) {
+    m_frame_cap = fps;
+}
+
+RenderMode App::getRenderMode() const {
+    return m_render_mode;
+}
+
+void App::setRenderMode(RenderMode mode) {
+    // the levels are built again with the parts the new renderer draws
+    if (mode != m_render_mode)
+        m_level_cache.clear();
+    m_render_mode = mode;
+}
+
+std::size_t App::getInstancesMemory() const {
+    std::size_t total = 0;
+    for (const auto& [_, renderer] : m_instanced_renderers)
+        total += renderer->getInstancesMemory();
+    return total;
+}
+
+std::size_t App::getTilemapsMemory() const {
+    std::size_t total = 0;
+    for (const auto& [_, renderer] : m_tilemap_renderers)
+        total += renderer->getTilemapsMemory();
+    return total;
+}
+
+std::size_t App::getImpostorsMemory() const {
+    std::size_t total = 0;
+    for (const auto& [_, renderer] : m_impostor_renderers)
+        total += renderer->getTexturesMemory();
+    return total;
+}
+
+auto App::getLevelCache() -> LevelCache& {
+    return m_level_cache;
+}
+
 void App::processEvent(sogl::Event& event) {
     static bool camera_grabbed = false;
     static glm::vec<2, int> grab_pos;
+    static glm::vec<2, int> press_pos;
+
+    requestRedraw();
 
     if (auto resize = event.as<sogl::Event::Resize>()) {
         for (auto& [_, data] : m_projects) {
@@ -150,6 +543,8 @@ void App::processEvent(sogl::Event& event) {
                 if (projectOpened()) {
                     refreshActiveProject();
                 }
+            } else if (press->key == sogl::Key::F3) {
+                m_show_stats = !m_show_stats;
             }
         }
     }
@@ -158,12 +553,17 @@ void App::processEvent(sogl::Event& event) {
             if (mouse_press->button == sogl::MouseButton::Left) {
                 camera_grabbed = true;
                 grab_pos = m_window.getMousePosition();
+                press_pos = grab_pos;
             }
         }
     }
     else if (auto mouse_release = event.as<sogl::Event::MouseRelease>()) {
-        if (mouse_release->button == sogl::MouseButton::Left) {
+        if (mouse_release->button == sogl::MouseButton::Left && camera_grabbed) {
             camera_grabbed = false;
+            const auto delta = m_window.getMousePosition() - press_pos;
+            if (projectOpened() && std::abs(delta.x) + std::abs(delta.y) <= CLICK_MAX_DISTANCE) {
+                pickAt(getMouseWorldPosition());
+            }
         }
     }
     else if (auto move = event.as<sogl::Event::MouseMove>()) {
@@ -187,39 +587,237 @@ void App::processEvent(sogl::Event& event) {
     }
 }
 
-void App::renderActiveProject() {
-    static const glm::vec2 OFFSET = {layout::left_panel_width, layout::tabs_bar_height};
+glm::vec2 App::getMouseWorldPosition() {
+    const auto window_size = glm::vec2(m_window.getSize());
+    return getCamera().applyTransform(glm::vec2(m_window.getMousePosition()) - VIEW_OFFSET/2.f - window_size/2.f);
+}
 
-    const auto& active_project = getActiveProject();
+void App::pickAt(const glm::vec2& world_pos) {
+    auto& active_project = getActiveProject();
+    const auto& world = *active_project.selected_world;
 
-    m_shader.bind();
-    m_shader.setUniform("window_size", glm::vec2(m_window.getSize()));
-    m_shader.setUniform("offset", OFFSET);
-    m_shader.setUniform("transform", getCamera().getTransform());
+    if (active_project.render_entities) {
+        if (const auto* hit = world.entity_index.at(active_project.depth).pick(world_pos)) {
+            active_project.selected_level = hit->level;
+            active_project.selected_entity = hit->entity;
+            active_project.selected_field = nullptr;
+            return;
+        }
+    }
+    if (const auto* hit = world.level_index.at(active_project.depth).pick(world_pos)) {
+        if (*hit != active_project.selected_level) {
+            active_project.selected_level = *hit;
+            active_project.selected_entity = nullptr;
+            active_project.selected_field = nullptr;
+        }
+    }
+}
 
+void App::renderActiveProject() {
+    const auto& active_project = getActiveProject();
     const auto& world = *active_project.selected_world;
+    const auto* const* hovered_level = world.level_index.at(active_project.depth).pick(getMouseWorldPosition());
+
+    m_render_stats = {};
+    m_render_incomplete = false;
+
+    const auto view = getCamera().getViewRect(VIEW_OFFSET);
+
+    if (active_project.streamer != nullptr) {
+        // requested ahead, so that levels are loaded by the time they enter the view
+        const auto area = Rect{view.pos - view.size * STREAMING_MARGIN, view.size * (1.f + 2.f * STREAMING_MARGIN)};
+        for (const auto& [depth, _] : world.levels) {
+            if (depth > active_project.depth)
+                continue;
+            world.level_index.at(depth).query(area, m_visible_levels);
+            for (const auto* level : m_visible_levels)
+                active_project.streamer->request(*level);
+        }
+    }
+
+    // levels of the active depth are dimmed unless hovered or selected
+    const auto* hovered = hovered_level != nullptr ? *hovered_level : nullptr;
+    auto depthColor = [&](int depth) {
+        if (depth == active_project.depth)
+            return glm::vec4(1.f, 1.f, 1.f, 1.f);
+        auto opacity = 0.5f - static_cast<float>(std::abs(active_project.depth - depth))/6.f;
+        return glm::vec4(0.8f, 0.8f, 0.8f, opacity);
+    };
+    auto depthDim = [&](int depth) {
+        return depth == active_project.depth ? 0.9f : 1.f;
+    };
+    auto levelColor = [&](int depth, const LDtkProjectObjects::Level& level) {
+        auto color = depthColor(depth);
+        if (&level != hovered && &level != active_project.selected_level)
+            color = glm::vec4(color.r * depthDim(depth), color.g * depthDim(depth), color.b * depthDim(depth), color.a);
+        return color;
+    };
+
+    IntGridRenderer* intgrid = nullptr;
+    if (active_project.render_intgrid) {
+        auto& renderer = m_intgrid_renderers[active_project.path];
+        if (renderer == nullptr)
+            renderer = std::make_unique<IntGridRenderer>(m_level_cache);
+        intgrid = renderer.get();
+        intgrid->begin(glm::vec2(m_window.getSize()), VIEW_OFFSET, getCamera().getTransform());
+    }
+
+    BatchRenderer* batch = nullptr;
+    if (m_render_mode == RenderMode::Batched) {
+        auto& renderer = m_batch_renderers[active_project.path];
+        if (renderer == nullptr)
+            renderer = std::make_unique<BatchRenderer>(m_level_cache, active_project.textures);
+        batch = renderer.get();
+        batch->begin(glm::vec2(m_window.getSize()), VIEW_OFFSET, getCamera().getTransform(), active_project.render_entities);
+    }
+
+    InstancedRenderer* instanced = nullptr;
+    if (m_render_mode == RenderMode::Instanced) {
+        auto& renderer = m_instanced_renderers[active_project.path];
+        if (renderer == nullptr)
+            renderer = std::make_unique<InstancedRenderer>(m_level_cache);
+        instanced = renderer.get();
+        instanced->begin(glm::vec2(m_window.getSize()), VIEW_OFFSET, getCamera().getTransform());
+    }
+
+    TilemapRenderer* tilemap = nullptr;
+    if (m_render_mode == RenderMode::Tilemap) {
+        auto& renderer = m_tilemap_renderers[active_project.path];
+        if (renderer == nullptr)
+            renderer = std::make_unique<TilemapRenderer>(m_level_cache);
+        tilemap = renderer.get();
+        tilemap->begin(glm::vec2(m_window.getSize()), VIEW_OFFSET, getCamera().getTransform());
+    }
+
+    ImpostorRenderer* impostors = nullptr;
+    if (batch == nullptr && getCamera().getZoom() < ImpostorRenderer::scale) {
+        auto& renderer = m_impostor_renderers[active_project.path];
+        if (renderer == nullptr)
+            renderer = std::make_unique<ImpostorRenderer>(m_level_cache);
+        impostors = renderer.get();
+        impostors->begin(glm::vec2(m_window.getSize()), VIEW_OFFSET, getCamera().getTransform(),
+                         active_project.render_entities, intgrid != nullptr);
+    }
+
+    // layers of a level, with the main shader uniforms already set
+    auto drawLevel = [&](const LDtkProjectObjects::Level& level) {
+        for (auto layer_it = level.layers.rbegin(); layer_it < level.layers.rend(); layer_it++) {
+            if (!view.intersects(layer_it->bounds)) {
+                m_render_stats.layers_culled++;
+                continue;
+            }
+            m_render_stats.layers_drawn++;
+            if (intgrid != nullptr && intgrid->render(*layer_it))
+                continue;
+            if ((instanced != nullptr && instanced->render(*layer_it, level.bounds.pos))
+                || (tilemap != nullptr && tilemap->render(*layer_it))) {
+                if (active_project.render_entities && !layer_it->entities.empty()) {
+                    m_shader.bind();
+                    layer_it->renderEntities(m_shader);
+                }
+                continue;
+            }
+            if (instanced != nullptr || tilemap != nullptr || intgrid != nullptr)
+                m_shader.bind();
+            // the other renderers don't require the tiles geometry, it is built for the layers they can't draw
+            if (!layer_it->hasGeometry(true, false)) {
+                layer_it->buildGeometry(true, false);
+                layer_it->uploadGeometry(true, false);
+            }
+            layer_it->render(m_shader, active_project.render_entities);
+        }
+    };
+    // impostors are drawn with the layers geometry, the level filling the viewport
+    auto drawImpostor = [&](const LDtkProjectObjects::Level& level, const glm::vec2& size, const glm::vec3& transform) {
+        m_shader.bind();
+        m_shader.setUniform("window_size", size);
+        m_shader.setUniform("offset", glm::vec2(0, 0));
+        m_shader.setUniform("transform", transform);
+        m_shader.setUniform("color", glm::vec4(1.f, 1.f, 1.f, 1.f));
+        if (intgrid != nullptr) {
+            intgrid->begin(size, {0, 0}, transform);
+            intgrid->setColor(glm::vec4(1.f, 1.f, 1.f, 1.f));
+        }
+        for (auto layer_it = level.layers.rbegin(); layer_it < level.layers.rend(); layer_it++) {
+            if (intgrid != nullptr && intgrid->render(*layer_it))
+                continue;
+            m_shader.bind();
+            layer_it->render(m_shader, active_project.render_entities);
+        }
+    };
+
+    // the tiles geometry is only drawn by the main shader, the other renderers build their own data
+    const auto tiles_geometry = m_render_mode == RenderMode::Layers;
+    auto impostors_built = 0;
     for (const auto& [depth, levels] : world.levels) {
         if (depth > active_project.depth)
             continue;
-        for (const auto& level : levels) {
-            if (depth == active_project.depth) {
-                auto window_size = glm::vec2(m_window.getSize());
-                auto mouse_pos = getCamera().applyTransform(glm::vec2(m_window.getMousePosition()) - OFFSET/2.f - window_size/2.f);
-
-                if ((mouse_pos.x >= level.bounds.pos.x && mouse_pos.y >= level.bounds.pos.y
-                  && mouse_pos.x < level.bounds.pos.x + level.bounds.size.x
-                  && mouse_pos.y < level.bounds.pos.y + level.bounds.size.y)
-                  || &level == active_project.selected_level) {
-                    m_shader.setUniform("color", glm::vec4(1.f, 1.f, 1.f, 1.f));
-                } else {
-                    m_shader.setUniform("color", glm::vec4(0.9f, 0.9f, 0.9f, 1.f));
+        world.level_index.at(depth).query(view, m_visible_levels);
+        m_render_stats.levels_drawn += static_cast<int>(m_visible_levels.size());
+        m_render_stats.levels_culled += static_cast<int>(levels.size() - m_visible_levels.size());
+
+        if (impostors != nullptr) {
+            // only the levels without impostor need their geometry, a few impostors are built each frame
+            // and the other levels are drawn with their layers meanwhile
+            m_impostor_levels.clear();
+            m_drawn_levels.clear();
+            for (const auto* level : m_visible_levels) {
+                if (!impostors->has(*level))
+                    m_impostor_levels.push_back(level);
+                else
+                    m_drawn_levels.push_back(level);
+            }
+            m_level_cache.require(m_drawn_levels, ThreadPool::global(), false, false);
+            m_level_cache.require(m_impostor_levels, ThreadPool::global(), true, active_project.render_entities);
+            for (const auto* level : m_impostor_levels) {
+                if (impostors_built == IMPOSTOR_BUILDS_PER_FRAME) {
+                    m_render_incomplete = true;
+                    break;
+                }
+                impostors->build(*level, drawImpostor);
+                // the level is drawn with its impostor from now on
+                level->releaseGeometry();
+                impostors_built++;
+            }
+        } else if (batch != nullptr) {
+            m_level_cache.require(m_visible_levels, ThreadPool::global(), false, false);
+            batch->prepare(depth, m_visible_levels, ThreadPool::global());
+        } else {
+            m_level_cache.require(m_visible_levels, ThreadPool::global(), tiles_geometry, active_project.render_entities);
+        }
+        if (intgrid != nullptr)
+            intgrid->begin(glm::vec2(m_window.getSize()), VIEW_OFFSET, getCamera().getTransform());
+        m_shader.bind();
+        m_shader.setUniform("window_size", glm::vec2(m_window.getSize()));
+        m_shader.setUniform("offset", VIEW_OFFSET);
+        m_shader.setUniform("transform", getCamera().getTransform());
+
+        if (batch != nullptr) {
+            batch->setTint(depthColor(depth), depthDim(depth), hovered, active_project.selected_level);
+            batch->render(depth, intgrid);
+            continue;
+        }
+        for (const auto* level_ptr : m_visible_levels) {
+            const auto& level = *level_ptr;
+            const auto color = levelColor(depth, level);
+            if (impostors != nullptr) {
+                impostors->setColor(color);
+                if (impostors->render(level)) {
+                    m_render_stats.impostors_drawn++;
+                    continue;
                 }
-            } else {
-                auto opacity = 0.5f - static_cast<float>(std::abs(active_project.depth - depth))/6.f;
-                m_shader.setUniform("color", glm::vec4(0.8f, 0.8f, 0.8f, opacity));
             }
-            for (auto layer_it = level.layers.rbegin(); layer_it < level.layers.rend(); layer_it++)
-                layer_it->render(m_shader, active_project.render_entities);
+            if (intgrid != nullptr)
+                intgrid->setColor(color);
+            m_shader.bind();
+            m_shader.setUniform("color", color);
+            if (instanced != nullptr)
+                instanced->setColor(color);
+            if (tilemap != nullptr)
+                tilemap->setColor(color);
+            drawLevel(level);
         }
     }
+    m_level_cache.trim();
+    TextureManager::trim();
 }
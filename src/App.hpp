@@ -3,28 +3,65 @@
 #pragma once
 
 #include "AppImGui.hpp"
+#include "FileWatcher.hpp"
 #include "LDtkProject/LDtkProjectObjects.hpp"
 #include "LDtkProject/LDtkProject.hpp"
+#include "LDtkProject/LevelCache.hpp"
+#include "Renderer/BatchRenderer.hpp"
+#include "Renderer/ImpostorRenderer.hpp"
+#include "Renderer/InstancedRenderer.hpp"
+#include "Renderer/IntGridRenderer.hpp"
+#include "Renderer/TilemapRenderer.hpp"
 
 #include "imgui/imgui.h"
 
 #include <LDtkLoader/World.hpp>
 #include <sogl/sogl.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <ctime>
 #include <functional>
+#include <future>
 #include <map>
+#include <memory>
+#include <set>
 #include <vector>
 #include <string>
 
+enum class RenderMode {
+    Layers,
+    Batched,
+    Instanced,
+    Tilemap
+};
+
+struct RenderStats {
+    int levels_drawn = 0;
+    int levels_culled = 0;
+    int layers_drawn = 0;
+    int layers_culled = 0;
+    int impostors_drawn = 0;
+};
+
+// Project being loaded by a worker thread
+struct LoadingProject {
+    std::unique_ptr<LDtkProject> project;
+    std::shared_ptr<std::atomic<float>> progress;
+    std::future<bool> result;
+};
+
 class App {
 public:
     App();
-    bool loadLDtkFile(const char* path);
+    // reuse_textures keeps the tilesets of a loaded version of the project, when their changes are reloaded apart
+    bool loadLDtkFile(const char* path, bool reuse_textures = false);
     void unloadLDtkFile(const char* path);
 
     auto getWindow() -> sogl::Window&;
 
     auto allProjects() -> std::map<std::string, LDtkProject>&;
+    auto loadingProjects() const -> const std::map<std::string, LoadingProject>&;
 
     bool projectOpened();
 
@@ -34,22 +71,86 @@ public:
 
     Camera2D& getCamera();
 
+    auto getRenderStats() const -> const RenderStats&;
+    bool statsVisible() const;
+
+    // redraw on demand waits for events and draws only when something changed
+    bool redrawOnDemand() const;
+    void setRedrawOnDemand(bool on_demand);
+    void requestRedraw();
+    // 0 when frames are not capped
+    int getFrameCap() const;
+    void setFrameCap(int fps);
+    // process CPU usage over the last second without any frame drawn, or with frames drawn, 100 being one core
+    float getCpuUsage(bool idle) const;
+
+    RenderMode getRenderMode() const;
+    void setRenderMode(RenderMode mode);
+    std::size_t getInstancesMemory() const;
+    std::size_t getTilemapsMemory() const;
+    std::size_t getImpostorsMemory() const;
+    auto getLevelCache() -> LevelCache&;
+
     void run();
 
 private:
     void processEvent(sogl::Event& event);
+    void finishLoadingProjects();
+    // moves the view, selection and unchanged levels GPU data of an opened project to its reloaded version
+    void reuseProject(LDtkProject& previous, LDtkProject& project);
+    void watchProject(const LDtkProject& project);
+    void reloadChangedFiles();
+    void streamLevels();
+    bool redrawPending() const;
+    bool shouldRedraw() const;
+    void frameDrawn();
+    void updateCpuUsage(bool drawn);
 
     void renderActiveProject();
 
+    glm::vec2 getMouseWorldPosition();
+    void pickAt(const glm::vec2& world_pos);
+
     sogl::Window m_window;
     sogl::Shader m_shader;
 
     AppImGui m_imgui;
 
     std::map<std::string, LDtkProject> m_projects;
+    std::map<std::string, LoadingProject> m_loading_projects;
+    // declared before the renderers, which release their data through it
+    LevelCache m_level_cache;
+    std::map<std::string, std::unique_ptr<BatchRenderer>> m_batch_renderers;
+    std::map<std::string, std::unique_ptr<InstancedRenderer>> m_instanced_renderers;
+    std::map<std::string, std::unique_ptr<IntGridRenderer>> m_intgrid_renderers;
+    std::map<std::string, std::unique_ptr<TilemapRenderer>> m_tilemap_renderers;
+    std::map<std::string, std::unique_ptr<ImpostorRenderer>> m_impostor_renderers;
+    FileWatcher m_watcher;
+    // projects written while they were being loaded
+    std::set<std::string> m_pending_reloads;
 
     LDtkProject* m_selected_project = nullptr;
 
+    RenderStats m_render_stats;
+    std::vector<const LDtkProjectObjects::Level*> m_visible_levels;
+    std::vector<const LDtkProjectObjects::Level*> m_impostor_levels;
+    std::vector<const LDtkProjectObjects::Level*> m_drawn_levels;
+    bool m_show_stats = false;
+    RenderMode m_render_mode = RenderMode::Layers;
+
+    // opt-in from the stats window, frames are drawn continuously by default
+    bool m_redraw_on_demand = false;
+    int m_redraw_frames = 0;
+    // some levels were not drawn in their final form, more frames are needed
+    bool m_render_incomplete = false;
+    int m_frame_cap = 0;
+    std::chrono::steady_clock::time_point m_last_draw;
+    std::chrono::steady_clock::time_point m_cpu_start;
+    std::clock_t m_cpu_clock = 0;
+    int m_cpu_frames = 0;
+    float m_cpu_idle = 0;
+    float m_cpu_active = 0;
+
     static constexpr auto vert_shader = GLSL(330 core,
         precision highp float;
         uniform vec2 window_size;
@@ -3,12 +3,32 @@
 #include "AppImGui.hpp"
 #include "App.hpp"
 #include "Config.hpp"
+#include "TextureManager.hpp"
 
 #include <imgui/imgui.h>
 #include <imgui/imgui_internal.h>
 #include <imgui/imgui_impl_glfw.h>
 #include <imgui/imgui_impl_opengl3.h>
 
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+    // hover state of the previous frame, the same one the items styles pushed before their submission can use
+    bool wasHovered(ImGuiID id) {
+        return ImGui::GetCurrentContext()->HoveredIdPreviousFrame == id;
+    }
+
+    // id of the vertical scrollbar of a child window opened with BeginChildEx(nullptr, child_id) in the window frame
+    ImGuiID childScrollbarID(const char* frame, ImGuiID child_id) {
+        char name[256];
+        ImFormatString(name, IM_ARRAYSIZE(name), "%s/%08X", frame, child_id);
+        return ImHashStr("#SCROLLY", 0, ImHashStr(name));
+    }
+}
+
 AppImGui::AppImGui(App &app) : m_app(app) {
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -61,10 +81,16 @@ void AppImGui::render() {
     renderLeftPanel();
     if (m_app.projectOpened()) {
         renderDepthSelector();
+        if (m_app.statsVisible()) {
+            renderStats();
+        }
     }
-    else {
+    else if (m_app.loadingProjects().empty()) {
         renderInstructions();
     }
+    if (!m_app.loadingProjects().empty()) {
+        renderLoadingProgress();
+    }
     ImGui::Render();
 
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -78,45 +104,80 @@ void AppImGui::renderTabBar() {
     ImGui::Begin("TabBar", nullptr, imgui_window_flags | ImGuiWindowFlags_NoScrollWithMouse | ImGuiWindowFlags_NoScrollbar);
     ImGui::BeginTabBar("ProjectsTabs", ImGuiTabBarFlags_AutoSelectNewTabs);
 
-    std::map<std::string, bool> worlds_tabs;
-    for (auto& [path, _] : m_app.allProjects()) {
+    // copied, the project key is erased by the unload
+    std::string closed_path;
+    for (auto& [path, project] : m_app.allProjects()) {
         if (path.empty())
             continue;
-        worlds_tabs[path] = true;
-        auto filename = std::filesystem::path(path).filename().string();
-        auto label = filename.append("##"+path);
+        const auto& labels = getPathLabels(path);
+        auto open = true;
         auto is_selected = m_app.getActiveProject().path == path;
-        auto is_hovered = ImGui::HoveredItemLabel() == "TabBar/ProjectsTabs/"+label.substr(0, 56);
+        // the tab is inside the tab bar ID scope, its ID is the one BeginTabItem computes
+        auto is_hovered = wasHovered(ImGui::GetID(labels.tab.c_str()));
         if (is_selected || is_hovered) {
             ImGui::PushStyleColor(ImGuiCol_Text, colors::text_black);
         }
-        if (ImGui::BeginTabItem(label.c_str(), &worlds_tabs[path])) {
-            m_app.setActiveProject(m_app.allProjects().at(path));
+        if (ImGui::BeginTabItem(labels.tab.c_str(), &open)) {
+            m_app.setActiveProject(project);
             ImGui::EndTabItem();
         }
         if (is_selected || is_hovered) {
             ImGui::PopStyleColor();
         }
-    }
-    for (auto& [path, open] : worlds_tabs) {
         if (!open) {
-            m_app.unloadLDtkFile(path.c_str());
+            closed_path = path;
         }
     }
+    for (const auto& [path, loading] : m_app.loadingProjects()) {
+        if (m_app.allProjects().count(path) > 0)
+            continue;
+        ImGui::TabItemButton(getPathLabels(path).loading_tab.c_str());
+    }
+    if (!closed_path.empty()) {
+        m_app.unloadLDtkFile(closed_path.c_str());
+    }
+    // labels of the closed projects
+    for (auto it = m_path_labels.begin(); it != m_path_labels.end();) {
+        if (m_app.allProjects().count(it->first) == 0 && m_app.loadingProjects().count(it->first) == 0)
+            it = m_path_labels.erase(it);
+        else
+            ++it;
+    }
 
     ImGui::EndTabBar();
     ImGui::End();
     ImGui::PopStyleVar();
 }
 
-void AppImGui::decorateImGuiExpandableScrollbar(const char* frame, const char* id,
-                                                const std::function<void(AppImGui*)>& fn) {
+void AppImGui::focus(const LDtkProjectObjects::World& world, const LDtkProjectObjects::Level& level,
+                     const LDtkProjectObjects::Entity* entity) {
+    auto& active_project = m_app.getActiveProject();
+    const auto& bounds = entity != nullptr ? entity->bounds : level.bounds;
+    auto center = bounds.pos + bounds.size / 2.f;
+    active_project.selected_world = &world;
+    active_project.depth = level.data.depth;
+    active_project.selected_level = &level;
+    active_project.selected_entity = entity;
+    active_project.selected_field = nullptr;
+    m_app.getCamera().centerOn(center.x, center.y);
+}
+
+auto AppImGui::getPathLabels(const std::string& path) -> const PathLabels& {
+    auto it = m_path_labels.find(path);
+    if (it == m_path_labels.end()) {
+        auto filename = std::filesystem::path(path).filename().string();
+        it = m_path_labels.emplace(path, PathLabels{filename + "##" + path, filename + " (loading)##" + path, filename}).first;
+    }
+    return it->second;
+}
+
+void AppImGui::decorateImGuiExpandableScrollbar(const char* frame, const char* id, void (AppImGui::*fn)()) {
     bool scrollbar_hovered = false;
-    if (std::string(ImGui::HoveredItemLabel()) == frame + ("/" + ImGui::IDtoString(ImGui::GetID(id))) + "/#SCROLLY") {
+    if (wasHovered(childScrollbarID(frame, ImGui::GetID(id)))) {
         scrollbar_hovered = true;
         ImGui::PushStyleVar(ImGuiStyleVar_ScrollbarSize, window::scrollbar_focused_width);
     }
-    fn(this);
+    (this->*fn)();
     if (scrollbar_hovered) {
         ImGui::PopStyleVar();
     }
@@ -156,6 +217,10 @@ void AppImGui::renderLeftPanel() {
 
         ImGui::Pad(15, 18);
 
+        decorateImGuiExpandableScrollbar(frame_name, "SearchResults", &AppImGui::renderLeftPanel_Search);
+
+        ImGui::Pad(15, 18);
+
         decorateImGuiExpandableScrollbar(frame_name, "Levels", &AppImGui::renderLeftPanel_LevelsList);
 
         ImGui::Pad(15, 18);
@@ -186,7 +251,8 @@ void AppImGui::renderLeftPanel_WorldsSelector() {
     if (ImGui::BeginCombo("##WorldsSelect", nullptr, ImGuiComboFlags_CustomPreview)) {
         for (const auto& world : active_project.objects->worlds) {
             bool is_selected = active_project.selected_world == &world;
-            if (ImGui::Selectable(("##"+world.data.getName()).c_str(), is_selected)) {
+            ImGui::PushID(&world);
+            if (ImGui::Selectable("##World", is_selected)) {
                 active_project.selected_world = &world;
                 active_project.selected_level = &world.levels.at(0)[0];
                 active_project.selected_entity = nullptr;
@@ -197,6 +263,7 @@ void AppImGui::renderLeftPanel_WorldsSelector() {
                 ImGui::TextCenteredColored(colors::text_black, world.data.getName().c_str());
             else
                 ImGui::TextCenteredColored(colors::text_white, world.data.getName().c_str());
+            ImGui::PopID();
         }
         ImGui::EndCombo();
     }
@@ -213,27 +280,80 @@ void AppImGui::renderLeftPanel_WorldsSelector() {
     }
 }
 
+void AppImGui::renderLeftPanel_Search() {
+    auto& active_project = m_app.getActiveProject();
+    ImGui::SetNextItemWidth(layout::left_panel_width);
+    if (ImGui::InputTextWithHint("##Search", "Search", active_project.search_text.data(), active_project.search_text.size())) {
+        active_project.search();
+    }
+    if (active_project.search_text[0] == '\0')
+        return;
+
+    const auto& results = active_project.search_results;
+    ImGui::AlignTextToFramePadding();
+    if (active_project.search_matches > results.size())
+        ImGui::Text("Results (%zu of %zu)", results.size(), active_project.search_matches);
+    else
+        ImGui::Text("Results (%zu)", results.size());
+    ImGui::BeginListBox("SearchResults", {layout::left_panel_width, ImGui::GetTextLineHeightWithSpacing() * 6.75f});
+
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(results.size()));
+    while (clipper.Step()) {
+        for (auto i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+            const auto& result = results[i];
+            auto is_selected = result.entity != nullptr ? active_project.selected_entity == result.entity
+                                                        : active_project.selected_level == result.level && active_project.selected_entity == nullptr;
+            ImGui::PushID(i);
+            ImGui::Selectable("##Result", is_selected, ImGuiSelectableFlags_AllowItemOverlap);
+            if (ImGui::IsItemClicked(ImGuiMouseButton_Left)) {
+                focus(*result.world, *result.level, result.entity);
+            }
+            ImGui::SameLine();
+            char label[128];
+            if (result.entity != nullptr)
+                std::snprintf(label, sizeof(label), "%s (%s)", result.entity->data.getName().c_str(), result.level->data.name.c_str());
+            else
+                std::snprintf(label, sizeof(label), "%s", result.level->data.name.c_str());
+            if (is_selected || ImGui::IsItemHovered())
+                ImGui::TextCenteredColored(colors::text_black, label);
+            else
+                ImGui::TextCenteredColored(colors::text_white, label);
+            ImGui::PopID();
+        }
+    }
+
+    ImGui::EndListBox();
+}
+
 void AppImGui::renderLeftPanel_LevelsList() {
     auto& active_project = m_app.getActiveProject();
     ImGui::AlignTextToFramePadding();
     ImGui::Text("Levels");
     ImGui::BeginListBox("Levels", {layout::left_panel_width, ImGui::GetTextLineHeightWithSpacing() * 6.75f});
 
-    for (const auto& level : active_project.selected_world->levels.at(active_project.depth)) {
-        bool is_selected = active_project.selected_level == &level;
-        ImGui::Selectable(("##"+level.data.iid.str()).c_str(), is_selected, ImGuiSelectableFlags_AllowItemOverlap);
-        if (ImGui::IsItemClicked(ImGuiMouseButton_Left)) {
-            active_project.selected_level = &level;
-            auto level_center = level.bounds.pos + level.bounds.size / 2.f;
-            m_app.getCamera().centerOn(level_center.x, level_center.y);
-            active_project.selected_entity = nullptr;
-            active_project.selected_field = nullptr;
+    // only the visible rows are submitted
+    const auto& levels = active_project.selected_world->levels.at(active_project.depth);
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(levels.size()));
+    while (clipper.Step()) {
+        for (auto i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+            const auto& level = levels[i];
+            bool is_selected = active_project.selected_level == &level;
+            ImGui::Selectable(level.label_id.c_str(), is_selected, ImGuiSelectableFlags_AllowItemOverlap);
+            if (ImGui::IsItemClicked(ImGuiMouseButton_Left)) {
+                active_project.selected_level = &level;
+                auto level_center = level.bounds.pos + level.bounds.size / 2.f;
+                m_app.getCamera().centerOn(level_center.x, level_center.y);
+                active_project.selected_entity = nullptr;
+                active_project.selected_field = nullptr;
+            }
+            ImGui::SameLine();
+            if (is_selected || ImGui::IsItemHovered())
+                ImGui::TextCenteredColored(colors::text_black, level.data.name.c_str());
+            else
+                ImGui::TextCenteredColored(colors::text_white, level.data.name.c_str());
         }
-        ImGui::SameLine();
-        if (is_selected || ImGui::IsItemHovered())
-            ImGui::TextCenteredColored(colors::text_black, level.data.name.c_str());
-        else
-            ImGui::TextCenteredColored(colors::text_white, level.data.name.c_str());
     }
 
     ImGui::EndListBox();
@@ -244,8 +364,15 @@ void AppImGui::renderLeftPanel_EntitiesList() {
 
     ImGui::AlignTextToFramePadding();
     ImGui::Text("Entities");
-    ImGui::SameLine(layout::left_panel_width - 60);
+    ImGui::SameLine(layout::left_panel_width - 60 - 65);
     ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, {0, 1});
+    if (ImGui::Button(active_project.render_intgrid ? "Hide grid" : "Show grid", {60, ImGui::GetTextLineHeightWithSpacing()})) {
+        active_project.render_intgrid = !active_project.render_intgrid;
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("IntGrid layers");
+    }
+    ImGui::SameLine(layout::left_panel_width - 60);
     if (ImGui::Button(active_project.render_entities ? "Hide" : "Show", {50, ImGui::GetTextLineHeightWithSpacing()})) {
         active_project.render_entities = !active_project.render_entities;
     }
@@ -254,11 +381,14 @@ void AppImGui::renderLeftPanel_EntitiesList() {
         ImGui::BeginListBox("Entities", {layout::left_panel_width, ImGui::GetTextLineHeightWithSpacing() * 6.75f});
 
         if (active_project.selected_level != nullptr) {
-            const auto& level = *active_project.selected_level;
-            for (const auto& layer : level.layers) {
-                for (const auto& entity : layer.entities) {
+            const auto& entities = active_project.selected_level->entities;
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>(entities.size()));
+            while (clipper.Step()) {
+                for (auto i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                    const auto& entity = *entities[i];
                     auto is_selected = active_project.selected_entity == &entity;
-                    ImGui::Selectable(("##" + entity.data.iid.str()).c_str(), is_selected);
+                    ImGui::Selectable(entity.label_id.c_str(), is_selected);
                     if (ImGui::IsItemClicked(ImGuiMouseButton_Left)) {
                         auto posx = entity.bounds.pos.x + entity.bounds.size.x * 0.5f;
                         auto posy = entity.bounds.pos.y + entity.bounds.size.y * 0.5f;
@@ -267,7 +397,8 @@ void AppImGui::renderLeftPanel_EntitiesList() {
                         m_app.getCamera().centerOn(static_cast<float>(posx), static_cast<float>(posy));
                     }
                     if (ImGui::IsItemHovered()) {
-                        ImGui::SetTooltip("%s", entity.data.iid.str().c_str());
+                        // the iid, without the id prefix
+                        ImGui::SetTooltip("%s", entity.label_id.c_str() + 2);
                     }
                     ImGui::SameLine();
                     if (is_selected || ImGui::IsItemHovered())
@@ -292,18 +423,23 @@ void AppImGui::renderLeftPanel_FieldsList() {
     ImGui::Text("Fields");
     ImGui::BeginListBox("Fields", {layout::left_panel_width, ImGui::GetTextLineHeightWithSpacing() * 6.75f});
 
-    for (const auto& field : active_project.selected_entity->fields) {
-        auto is_selected = active_project.selected_field == &field;
-        ImGui::Selectable(("##" + std::to_string(int(field.data.type)) + " " + field.data.name).c_str(), is_selected);
-        if (ImGui::IsItemClicked(ImGuiMouseButton_Left)) {
-            active_project.selected_field = &field;
-            active_project.selected_field_values = LDtkProject::fieldValuesToString(field.data, active_project.selected_entity->data);
+    const auto& fields = active_project.selected_entity->fields;
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(fields.size()));
+    while (clipper.Step()) {
+        for (auto i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+            const auto& field = fields[i];
+            auto is_selected = active_project.selected_field == &field;
+            ImGui::Selectable(field.label_id.c_str(), is_selected);
+            if (ImGui::IsItemClicked(ImGuiMouseButton_Left)) {
+                active_project.selected_field = &field;
+            }
+            ImGui::SameLine();
+            if (is_selected || ImGui::IsItemHovered())
+                ImGui::TextCenteredColored(colors::text_black, field.data.name.c_str());
+            else
+                ImGui::TextCenteredColored(colors::text_white, field.data.name.c_str());
         }
-        ImGui::SameLine();
-        if (is_selected || ImGui::IsItemHovered())
-            ImGui::TextCenteredColored(colors::text_black, field.data.name.c_str());
-        else
-            ImGui::TextCenteredColored(colors::text_white, field.data.name.c_str());
     }
 
     ImGui::EndListBox();
@@ -312,29 +448,60 @@ void AppImGui::renderLeftPanel_FieldsList() {
 void AppImGui::renderLeftPanel_FieldValues() {
     auto& active_project = m_app.getActiveProject();
     const auto& field = active_project.selected_field->data;
-    const auto& values = active_project.selected_field_values;
+    const auto& values = active_project.selected_entity->getFieldValues();
+    const auto index = active_project.selected_field->index;
+    // values heights are known from their lines count, without measuring the text
+    const auto value_height = [&](std::size_t value) {
+        return static_cast<float>(values.values[value].lines) * ImGui::GetTextLineHeight() + ImGui::GetStyle().ItemSpacing.y;
+    };
+
+    // EntityRef values are links to the referenced entity, followed once the values are drawn
+    const ldtk::Entity* followed = nullptr;
+    const auto value_text = [&](std::size_t value) {
+        const auto* target = values.values[value].target;
+        if (target != nullptr && ImGui::IsWindowHovered()) {
+            ImGui::SetMouseCursor(ImGuiMouseCursor_Hand);
+            ImGui::SetTooltip("Go to %s", target->iid.str().c_str());
+            if (ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+                followed = target;
+        }
+        ImGui::TextCentered(values.getText(value));
+    };
 
     ImGui::AlignTextToFramePadding();
-    ImGui::Text("%s", (LDtkProject::fieldTypeEnumToString(field.type) + " field").c_str());
+    ImGui::Text("%s field", LDtkProject::fieldTypeEnumToString(field.type).c_str());
     if (!LDtkProject::fieldTypeIsArray(field.type)) {
-        auto height = ImGui::CalcTextSize(values.at(0).c_str()).y + ImGui::GetStyle().ItemSpacing.y;
-        ImGui::BeginChildFrame(ImGui::GetID("FieldValue"), ImVec2(layout::left_panel_width, height + ImGui::GetStyle().FramePadding.y));
-        ImGui::TextCentered(values.at(0).c_str());
+        const auto value = values.begin(index);
+        ImGui::BeginChildFrame(ImGui::GetID("FieldValue"), ImVec2(layout::left_panel_width, value_height(value) + ImGui::GetStyle().FramePadding.y));
+        value_text(value);
         ImGui::EndChildFrame();
     }
     else {
         ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, {3, ImGui::GetStyle().FramePadding.y});
         ImGui::BeginChildFrame(ImGui::GetID("FieldValue"), ImVec2(layout::left_panel_width, ImGui::GetTextLineHeightWithSpacing()*6.5f));
-        int i = 0;
-        for (const auto& val : values) {
-            auto height = ImGui::CalcTextSize(val.c_str()).y + ImGui::GetStyle().ItemSpacing.y;
-            ImGui::BeginChildFrame(ImGui::GetID(std::to_string(i++).c_str()), ImVec2(layout::left_panel_width-7, height + ImGui::GetStyle().FramePadding.y));
-            ImGui::TextCentered(val.c_str());
+        // values out of the visible area only reserve their space
+        const auto visible_top = ImGui::GetScrollY();
+        const auto visible_bottom = visible_top + ImGui::GetWindowHeight();
+        for (auto value = values.begin(index); value < values.end(index); ++value) {
+            const auto size = ImVec2(layout::left_panel_width-7, value_height(value) + ImGui::GetStyle().FramePadding.y);
+            const auto top = ImGui::GetCursorPosY();
+            if (top + size.y < visible_top || top > visible_bottom) {
+                ImGui::Dummy(size);
+                continue;
+            }
+            ImGui::BeginChildFrame(ImGui::GetID(static_cast<const void*>(values.getText(value))), size);
+            value_text(value);
             ImGui::EndChildFrame();
         }
         ImGui::EndChildFrame();
         ImGui::PopStyleVar();
     }
+
+    if (followed != nullptr) {
+        const auto* location = active_project.objects->findIid(followed->iid.str());
+        if (location != nullptr && location->entity != nullptr)
+            focus(*location->world, *location->level, location->entity);
+    }
 }
 
 void AppImGui::renderDepthSelector() {
@@ -352,16 +519,20 @@ void AppImGui::renderDepthSelector() {
 
         for (auto it = world.levels.rbegin(); it != world.levels.rend(); it++) {
             const auto& [depth, _] = *it;
-            ImGui::Selectable(("##"+std::to_string(depth)).c_str(), active_project.depth == depth);
+            char label[16];
+            std::snprintf(label, sizeof(label), "%d", depth);
+            ImGui::PushID(depth);
+            ImGui::Selectable("##Depth", active_project.depth == depth);
             if (ImGui::IsItemClicked(ImGuiMouseButton_Left)) {
                 active_project.depth = depth;
                 active_project.selected_level = &world.levels.at(depth)[0];
             }
             ImGui::SameLine();
             if (active_project.depth == depth || ImGui::IsItemHovered())
-                ImGui::TextCenteredColored(colors::text_black, std::to_string(depth).c_str());
+                ImGui::TextCenteredColored(colors::text_black, label);
             else
-                ImGui::TextCenteredColored(colors::text_white, std::to_string(depth).c_str());
+                ImGui::TextCenteredColored(colors::text_white, label);
+            ImGui::PopID();
         }
         ImGui::End();
         ImGui::PopStyleVar();
@@ -369,6 +540,175 @@ void AppImGui::renderDepthSelector() {
     }
 }
 
+void AppImGui::renderStats() {
+    const auto& stats = m_app.getRenderStats();
+    const auto window_size = m_app.getWindow().getSize();
+
+    ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, window::pinned_padding);
+    ImGui::PushStyleVar(ImGuiStyleVar_WindowRounding, window::pinned_rounding);
+    ImGui::SetNextWindowSize({layout::stats_width, 0.f});
+    ImGui::SetNextWindowPos({static_cast<float>(window_size.x) - layout::stats_width - 15,
+                             layout::tabs_bar_height + 15});
+    ImGui::Begin("Stats", nullptr, imgui_window_flags);
+    static constexpr const char* render_modes[] = {"Layers", "Batched", "Instanced", "Tilemap"};
+    auto render_mode = static_cast<int>(m_app.getRenderMode());
+    ImGui::SetNextItemWidth(layout::stats_width - window::pinned_padding.x * 2);
+    if (ImGui::Combo("##RenderMode", &render_mode, render_modes, IM_ARRAYSIZE(render_modes))) {
+        m_app.setRenderMode(static_cast<RenderMode>(render_mode));
+    }
+    auto on_demand = m_app.redrawOnDemand();
+    if (ImGui::Checkbox("Redraw on demand", &on_demand)) {
+        m_app.setRedrawOnDemand(on_demand);
+    }
+    auto frame_cap = m_app.getFrameCap();
+    ImGui::SetNextItemWidth(layout::stats_width - window::pinned_padding.x * 2);
+    if (ImGui::SliderInt("##FrameCap", &frame_cap, 0, 240, frame_cap == 0 ? "FPS cap: off" : "FPS cap: %d")) {
+        m_app.setFrameCap(frame_cap);
+    }
+    ImGui::Text("CPU idle: %.0f%%, active: %.0f%%", m_app.getCpuUsage(true), m_app.getCpuUsage(false));
+    renderStats_Profiler();
+    ImGui::Separator();
+    ImGui::Text("Levels drawn: %d", stats.levels_drawn);
+    ImGui::Text("Levels culled: %d", stats.levels_culled);
+    ImGui::Text("Layers drawn: %d", stats.layers_drawn);
+    ImGui::Text("Layers culled: %d", stats.layers_culled);
+    ImGui::Text("Impostors: %d (%.1f MiB)", stats.impostors_drawn, static_cast<float>(m_app.getImpostorsMemory()) / (1024.f * 1024.f));
+    if (m_app.getRenderMode() == RenderMode::Instanced) {
+        ImGui::Text("Instances: %.1f KiB", static_cast<float>(m_app.getInstancesMemory()) / 1024.f);
+    } else if (m_app.getRenderMode() == RenderMode::Tilemap) {
+        ImGui::Text("Tilemaps: %.1f KiB", static_cast<float>(m_app.getTilemapsMemory()) / 1024.f);
+    }
+    if (const auto& streamer = m_app.getActiveProject().streamer) {
+        ImGui::Text("Streamed: %zu/%zu (%zu pending)", streamer->getLoadedCount(), streamer->getLevelsCount(),
+                    streamer->getPendingCount());
+        // not released with the levels since the objects reference them, counted in the levels memory
+        const auto definitions = streamer->getProjectsCount() * streamer->getHeaderSize();
+        ImGui::Text("Definitions copies: %zu (~%.1f MiB)", streamer->getProjectsCount(),
+                    static_cast<float>(definitions) / (1024.f * 1024.f));
+    }
+    auto& cache = m_app.getLevelCache();
+    ImGui::Text("Resident levels: %zu", cache.getResidentCount());
+    ImGui::Text("Levels memory: %.1f MiB", static_cast<float>(cache.getUsedMemory()) / (1024.f * 1024.f));
+    auto budget_mib = static_cast<int>(cache.getBudget() / (1024 * 1024));
+    ImGui::SetNextItemWidth(layout::stats_width - window::pinned_padding.x * 2);
+    if (ImGui::SliderInt("##Budget", &budget_mib, 1, 1024, "Budget: %d MiB")) {
+        cache.setBudget(static_cast<std::size_t>(budget_mib) * 1024 * 1024);
+    }
+    renderStats_Textures();
+    const auto& timings = m_app.getActiveProject().timings;
+    ImGui::Separator();
+    ImGui::Text("Read: %.1f ms (%.1f MiB)", timings.read_ms, static_cast<double>(timings.file_size) / (1024. * 1024.));
+    if (timings.peak_memory_kib > 0)
+        ImGui::Text("Parse: %.1f ms (peak memory %.1f MiB)", timings.parse_ms, static_cast<double>(timings.peak_memory_kib) / 1024.);
+    else
+        ImGui::Text("Parse: %.1f ms", timings.parse_ms);
+    ImGui::Text("Build: %.1f ms (%u threads)", timings.build_ms, timings.threads);
+    if (const auto& geometry_cache = m_app.getActiveProject().geometry_cache) {
+        ImGui::Text("Cache: %.1f ms (%zu hits, %zu misses)", timings.cache_ms, geometry_cache->getHitsCount(),
+                    geometry_cache->getMissesCount());
+    }
+    ImGui::Text("Index: %.1f ms", timings.index_ms);
+    ImGui::Text("Decode: %.1f ms", timings.decode_ms);
+    ImGui::Text("Upload: %.1f ms", timings.upload_ms);
+    ImGui::End();
+    ImGui::PopStyleVar();
+    ImGui::PopStyleVar();
+}
+
+void AppImGui::renderStats_Textures() {
+    constexpr auto mib = 1024.f * 1024.f;
+    ImGui::Separator();
+    ImGui::Text("Textures: %zu (%.1f MiB)", TextureManager::getCount(), static_cast<float>(TextureManager::getMemory()) / mib);
+    for (const auto& [path, project] : m_app.allProjects()) {
+        ImGui::Text("  %s: %.1f MiB", project.objects->name.c_str(), static_cast<float>(project.getTexturesMemory()) / mib);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("%s", path.c_str());
+    }
+    ImGui::Text("  Unused: %.1f MiB", static_cast<float>(TextureManager::getUnusedMemory()) / mib);
+    auto budget_mib = static_cast<int>(TextureManager::getBudget() / (1024 * 1024));
+    ImGui::SetNextItemWidth(layout::stats_width - window::pinned_padding.x * 2);
+    if (ImGui::SliderInt("##TexturesBudget", &budget_mib, 16, 4096, "Budget: %d MiB")) {
+        TextureManager::setBudget(static_cast<std::size_t>(budget_mib) * 1024 * 1024);
+    }
+}
+
+void AppImGui::renderStats_Profiler() {
+    const auto frames_count = Profiler::getFramesCount();
+    if (frames_count == 0)
+        return;
+
+    auto max_time = 0.f;
+    for (std::size_t age = 0; age < frames_count; ++age) {
+        const auto& frame = Profiler::getFrame(age);
+        const auto time = static_cast<float>(frame.end_us - frame.begin_us) / 1000.f;
+        m_frame_times[frames_count - 1 - age] = time;
+        max_time = std::max(max_time, time);
+    }
+    const auto& last = Profiler::getFrame(0);
+    char overlay[32];
+    std::snprintf(overlay, sizeof(overlay), "%.2f ms", m_frame_times[frames_count - 1]);
+    ImGui::PlotLines("##FrameTimes", m_frame_times.data(), static_cast<int>(frames_count), 0, overlay,
+                     0.f, std::max(max_time, 1000.f / 60.f), {layout::stats_width - window::pinned_padding.x * 2, 50.f});
+
+    // stages of the last frame, averaged over the kept frames
+    for (const auto& sample : last.samples) {
+        auto total = 0.;
+        for (std::size_t age = 0; age < frames_count; ++age) {
+            for (const auto& other : Profiler::getFrame(age).samples) {
+                if (other.name == sample.name)
+                    total += other.end_us - other.begin_us;
+            }
+        }
+        ImGui::Text("%s: %.2f ms", sample.name, total / 1000. / static_cast<double>(frames_count));
+    }
+    auto gpu_total = 0.;
+    auto gpu_frames = 0;
+    for (std::size_t age = 0; age < frames_count; ++age) {
+        if (Profiler::getFrame(age).gpu_ms >= 0) {
+            gpu_total += Profiler::getFrame(age).gpu_ms;
+            gpu_frames++;
+        }
+    }
+    if (gpu_frames > 0)
+        ImGui::Text("GPU world: %.2f ms", gpu_total / gpu_frames);
+
+    ImGui::Text("Draw calls: %d", last.draw_calls);
+    ImGui::Text("Vertices: %zu", last.vertices);
+    ImGui::Text("Texture binds: %d", last.texture_binds);
+    if (Profiler::countsAllocations())
+        ImGui::Text("Allocations: %zu", last.allocations);
+    if (ImGui::Button("Save trace")) {
+        if (Profiler::saveTrace("ldtkviewer-trace.json"))
+            std::cout << "Trace saved to ldtkviewer-trace.json" << std::endl;
+        else
+            std::cerr << "Failed to save trace" << std::endl;
+    }
+}
+
+void AppImGui::renderLoadingProgress() {
+    const auto& loading_projects = m_app.loadingProjects();
+    const auto line_height = ImGui::GetFrameHeightWithSpacing();
+    const auto window_w = layout::loading_width;
+    const auto window_h = window::pinned_padding.y * 2 + line_height * 2 * static_cast<float>(loading_projects.size());
+    const auto window_size = m_app.getWindow().getSize();
+
+    ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, window::pinned_padding);
+    ImGui::PushStyleVar(ImGuiStyleVar_WindowRounding, window::pinned_rounding);
+    ImGui::SetNextWindowSize({window_w, window_h});
+    ImGui::SetNextWindowPos({layout::left_panel_width + (static_cast<float>(window_size.x) - layout::left_panel_width - window_w) / 2,
+                             static_cast<float>(window_size.y) - window_h - 15});
+    ImGui::Begin("Loading", nullptr, imgui_window_flags);
+    for (const auto& [path, loading] : loading_projects) {
+        ImGui::TextCentered(getPathLabels(path).filename.c_str());
+        ImGui::PushStyleColor(ImGuiCol_PlotHistogram, colors::selected);
+        ImGui::ProgressBar(loading.progress->load(), {-1.f, 0.f});
+        ImGui::PopStyleColor();
+    }
+    ImGui::End();
+    ImGui::PopStyleVar();
+    ImGui::PopStyleVar();
+}
+
 void AppImGui::renderInstructions() {
     constexpr auto imgui_window_w = 400;
     constexpr auto imgui_window_h = 200;
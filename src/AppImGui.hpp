@@ -2,9 +2,14 @@
 
 #pragma once
 
+#include "LDtkProject/LDtkProjectObjects.hpp"
+#include "Profiler.hpp"
+
 #include <imgui/imgui.h>
 
-#include <functional>
+#include <array>
+#include <map>
+#include <string>
 
 class App;
 
@@ -19,18 +24,37 @@ private:
                                                | ImGuiWindowFlags_NoResize
                                                | ImGuiWindowFlags_NoDecoration;
 
+    // labels derived from the projects paths, built once per path so that the frames don't allocate
+    struct PathLabels {
+        std::string tab;
+        std::string loading_tab;
+        std::string filename;
+    };
+
     App& m_app;
+    std::map<std::string, PathLabels> m_path_labels;
+    // frame times from the oldest, for the profiler graph
+    std::array<float, Profiler::frames_count> m_frame_times = {};
 
     void renderTabBar();
     void renderLeftPanel();
     void renderLeftPanel_WorldsSelector();
+    void renderLeftPanel_Search();
     void renderLeftPanel_LevelsList();
     void renderLeftPanel_EntitiesList();
     void renderLeftPanel_FieldsList();
     void renderLeftPanel_FieldValues();
     void renderDepthSelector();
+    void renderStats();
+    void renderStats_Profiler();
+    void renderStats_Textures();
     void renderInstructions();
+    void renderLoadingProgress();
+
+    auto getPathLabels(const std::string& path) -> const PathLabels&;
+    // selects the level, or the entity when not null, of the active project and centers the camera on it
+    void focus(const LDtkProjectObjects::World& world, const LDtkProjectObjects::Level& level,
+               const LDtkProjectObjects::Entity* entity);
 
-    void decorateImGuiExpandableScrollbar(const char* frame, const char* id,
-                                          const std::function<void(AppImGui*)>& fn);
+    void decorateImGuiExpandableScrollbar(const char* frame, const char* id, void (AppImGui::*fn)());
 };
@@ -70,3 +70,9 @@ glm::vec3 Camera2D::getTransform() const {
         round<3>(m_transform.z)
     };
 }
+
+Rect Camera2D::getViewRect(const glm::vec2& offset) const {
+    auto top_left = applyTransform(-m_size / 2.f - offset / 2.f);
+    auto bottom_right = applyTransform(m_size / 2.f - offset / 2.f);
+    return {top_left, bottom_right - top_left};
+}
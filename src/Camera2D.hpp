@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include "Rect.hpp"
+
 #include <glm/glm.hpp>
 
 class Camera2D {
@@ -23,6 +25,9 @@ public:
     glm::vec2 applyTransform(const glm::vec2 point) const;
     glm::vec3 getTransform() const;
 
+    // world-space rectangle covered by the window, offset being the one passed to the shader
+    Rect getViewRect(const glm::vec2& offset) const;
+
 private:
     glm::vec2 m_size;
     glm::vec2 m_offset;
@@ -49,4 +49,8 @@ namespace layout {
 
     constexpr auto depth_selector_position = ImVec2{left_panel_width + 15, tabs_bar_height + 15};
     constexpr auto depth_selector_width = 45.f;
+
+    constexpr auto stats_width = 220.f;
+
+    constexpr auto loading_width = 300.f;
 }
@@ -0,0 +1,163 @@
+#include "Exporter.hpp"
+#include "LDtkProject/LDtkProjectObjects.hpp"
+#include "TextureManager.hpp"
+#include "ThreadPool.hpp"
+
+#include <LDtkLoader/Project.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // file name made of the characters that are safe on every file system
+    std::string fileName(const std::string& name) {
+        std::string result;
+        for (const auto c : name) {
+            const auto safe = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '-' || c == '_';
+            result += safe ? c : '_';
+        }
+        return result;
+    }
+
+    std::string lowerCase(std::string text) {
+        for (auto& c : text)
+            c = (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+        return text;
+    }
+
+    // source over destination, the blending used by the renderers
+    void blend(std::uint8_t* dst, const std::uint8_t* src, float opacity) {
+        const auto src_alpha = static_cast<float>(src[3]) / 255.f * opacity;
+        if (src_alpha <= 0.f)
+            return;
+        const auto dst_alpha = static_cast<float>(dst[3]) / 255.f * (1.f - src_alpha);
+        const auto alpha = src_alpha + dst_alpha;
+        for (int c = 0; c < 3; ++c)
+            dst[c] = static_cast<std::uint8_t>(std::lround((static_cast<float>(src[c]) * src_alpha + static_cast<float>(dst[c]) * dst_alpha) / alpha));
+        dst[3] = static_cast<std::uint8_t>(std::lround(alpha * 255.f));
+    }
+}
+
+bool Exporter::exportProject(const std::string& path, const std::string& directory, ThreadPool& pool, Stats& stats) {
+    auto start = Clock::now();
+    ldtk::Project project;
+    try {
+        project.loadFromFile(path);
+    } catch(std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return false;
+    }
+    const auto project_directory = LDtkProjectObjects::directoryOf(path);
+    std::map<std::string, Image> tilesets;
+    for (const auto& tileset : project.allTilesets())
+        if (!tileset.path.empty())
+            tilesets[project_directory + tileset.path];
+    TextureManager::prefetch(tilesets, pool);
+    stats.load_ms = elapsedMs(start);
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        std::cerr << "Failed to create directory " << directory << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    std::vector<std::pair<std::string, const ldtk::Level*>> levels;
+    std::unordered_set<std::string> names;
+    const auto multi_worlds = project.allWorlds().size() > 1;
+    for (const auto& world : project.allWorlds()) {
+        for (const auto& level : world.allLevels()) {
+            auto name = multi_worlds ? fileName(world.getName()) + "_" + fileName(level.name) : fileName(level.name);
+            // names differing by unsafe characters or by case would write the same file, the iid is unique
+            if (!names.insert(lowerCase(name)).second)
+                name += "_" + level.iid.str();
+            levels.emplace_back((std::filesystem::path(directory) / (name + ".png")).string(), &level);
+        }
+    }
+
+    start = Clock::now();
+    std::atomic<std::size_t> failed = 0;
+    std::mutex errors_mutex;
+    pool.parallelFor(levels.size(), [&](std::size_t index) {
+        const auto& [file, level] = levels[index];
+        Image image;
+        renderLevel(*level, tilesets, project_directory, image);
+        if (!image.savePNG(file)) {
+            failed++;
+            std::lock_guard lock(errors_mutex);
+            std::cerr << "Failed to write " << file << std::endl;
+        }
+    });
+    stats.render_ms = elapsedMs(start);
+    stats.levels = levels.size();
+    stats.failed = failed;
+    return failed == 0;
+}
+
+void Exporter::renderLevel(const ldtk::Level& level, const std::map<std::string, Image>& tilesets,
+                           const std::string& project_directory, Image& image) {
+    image.width = level.size.x;
+    image.height = level.size.y;
+    image.pixels.assign(static_cast<std::size_t>(image.width) * image.height * 4, 0);
+
+    // the first layers are on top
+    const auto& layers = level.allLayers();
+    for (auto layer_it = layers.rbegin(); layer_it < layers.rend(); layer_it++) {
+        const auto& layer = *layer_it;
+        if (layer.allTiles().empty())
+            continue;
+        const auto tileset_it = tilesets.find(project_directory + layer.getTileset().path);
+        if (tileset_it == tilesets.end() || tileset_it->second.pixels.empty())
+            continue;
+        const auto& tileset = tileset_it->second;
+        const auto opacity = layer.getOpacity();
+
+        for (const auto& tile : layer.allTiles()) {
+            // same tiles as Layer::buildTilesQuads
+            if (tile.getPosition().x < 0 || tile.getPosition().x > layer.getGridSize().x * layer.getCellSize()
+                || tile.getPosition().y < 0 || tile.getPosition().y > layer.getGridSize().y * layer.getCellSize())
+                continue;
+            // top left and bottom right vertices, flipped tiles have their texture coordinates swapped
+            const auto vertices = tile.getVertices();
+            const auto& tl = vertices[0];
+            const auto& br = vertices[2];
+            const auto x0 = static_cast<int>(std::lround(tl.pos.x));
+            const auto y0 = static_cast<int>(std::lround(tl.pos.y));
+            const auto w = static_cast<int>(std::lround(br.pos.x)) - x0;
+            const auto h = static_cast<int>(std::lround(br.pos.y)) - y0;
+            if (w <= 0 || h <= 0)
+                continue;
+            const auto scale_x = static_cast<float>(br.tex.x - tl.tex.x) / static_cast<float>(w);
+            const auto scale_y = static_cast<float>(br.tex.y - tl.tex.y) / static_cast<float>(h);
+
+            // nearest texel of each pixel center
+            for (int y = std::max(0, -y0); y < h && y0 + y < image.height; ++y) {
+                const auto ty = static_cast<int>(std::floor(static_cast<float>(tl.tex.y) + (static_cast<float>(y) + 0.5f) * scale_y));
+                if (ty < 0 || ty >= tileset.height)
+                    continue;
+                const auto dst_row = static_cast<std::size_t>(y0 + y) * image.width;
+                const auto* src_row = &tileset.pixels[static_cast<std::size_t>(ty) * tileset.width * 4];
+                for (int x = std::max(0, -x0); x < w && x0 + x < image.width; ++x) {
+                    const auto tx = static_cast<int>(std::floor(static_cast<float>(tl.tex.x) + (static_cast<float>(x) + 0.5f) * scale_x));
+                    if (tx < 0 || tx >= tileset.width)
+                        continue;
+                    blend(&image.pixels[(dst_row + static_cast<std::size_t>(x0 + x)) * 4], src_row + static_cast<std::size_t>(tx) * 4, opacity);
+                }
+            }
+        }
+    }
+}
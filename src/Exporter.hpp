@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Image.hpp"
+
+#include <LDtkLoader/Level.hpp>
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+class ThreadPool;
+
+// Renders the levels of a project on the CPU and writes them as PNG files, without window nor GL context.
+// Tile layers are composited from the tilesets images in the order and with the opacity of Layer::render,
+// entities and IntGrid values are not drawn.
+class Exporter {
+public:
+    struct Stats {
+        std::size_t levels = 0;
+        std::size_t failed = 0;
+        double load_ms = 0;
+        double render_ms = 0;
+    };
+
+    // writes one <level>.png file per level into directory (<world>_<level>.png for multi-worlds projects),
+    // the levels are rendered in parallel on the pool
+    static bool exportProject(const std::string& path, const std::string& directory, ThreadPool& pool, Stats& stats);
+
+    // tilesets images are keyed by their path, being the project directory followed by the tileset path
+    static void renderLevel(const ldtk::Level& level, const std::map<std::string, Image>& tilesets,
+                            const std::string& project_directory, Image& image);
+};
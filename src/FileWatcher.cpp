@@ -0,0 +1,153 @@
+#include "FileWatcher.hpp"
+
+#include <algorithm>
+
+#if defined(__linux__) && !defined(EMSCRIPTEN)
+    #include <sys/inotify.h>
+    #include <unistd.h>
+    #define FILE_WATCHER_INOTIFY
+#endif
+
+// writes closer than this are considered to be the same save
+constexpr auto SETTLE_DELAY = std::chrono::milliseconds(30);
+// modification times are compared at most this often, on systems without inotify
+constexpr auto CHECK_PERIOD = std::chrono::milliseconds(250);
+
+namespace {
+    std::string normalized(const std::string& path) {
+        std::error_code error;
+        auto absolute = std::filesystem::absolute(path, error);
+        return (error ? std::filesystem::path(path) : absolute).lexically_normal().generic_string();
+    }
+
+    std::filesystem::file_time_type writeTime(const std::string& path) {
+        std::error_code error;
+        const auto time = std::filesystem::last_write_time(path, error);
+        return error ? std::filesystem::file_time_type::min() : time;
+    }
+}
+
+FileWatcher::FileWatcher() {
+#if defined(FILE_WATCHER_INOTIFY)
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+#if defined(FILE_WATCHER_INOTIFY)
+    if (m_inotify >= 0)
+        ::close(m_inotify);
+#endif
+}
+
+void FileWatcher::watch(const std::string& owner, const std::string& path) {
+    const auto file_path = normalized(path);
+    auto& file = m_files[file_path];
+    const auto watched = std::any_of(file.watches.begin(), file.watches.end(), [&](const Change& watch) {
+        return watch.owner == owner;
+    });
+    if (watched)
+        return;
+    if (file.watches.empty())
+        file.write_time = writeTime(file_path);
+    file.watches.push_back({owner, path});
+    addDirectory(std::filesystem::path(file_path).parent_path().generic_string());
+}
+
+void FileWatcher::unwatch(const std::string& owner) {
+    for (auto it = m_files.begin(); it != m_files.end();) {
+        auto& watches = it->second.watches;
+        watches.erase(std::remove_if(watches.begin(), watches.end(), [&](const Change& watch) {
+            return watch.owner == owner;
+        }), watches.end());
+        it = watches.empty() ? m_files.erase(it) : std::next(it);
+    }
+    removeUnusedDirectories();
+}
+
+auto FileWatcher::poll() -> const std::vector<Change>& {
+    m_changed.clear();
+    if (m_inotify >= 0)
+        readEvents();
+    else
+        checkWriteTimes();
+
+    const auto now = Clock::now();
+    for (auto& [_, file] : m_files) {
+        if (file.pending && now - file.changed >= SETTLE_DELAY) {
+            file.pending = false;
+            m_changed.insert(m_changed.end(), file.watches.begin(), file.watches.end());
+        }
+    }
+    return m_changed;
+}
+
+void FileWatcher::addDirectory(const std::string& directory) {
+    if (m_directories.count(directory) > 0)
+        return;
+    auto descriptor = -1;
+#if defined(FILE_WATCHER_INOTIFY)
+    if (m_inotify >= 0)
+        descriptor = inotify_add_watch(m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+#endif
+    m_directories[directory] = descriptor;
+}
+
+void FileWatcher::removeUnusedDirectories() {
+    for (auto it = m_directories.begin(); it != m_directories.end();) {
+        const auto used = std::any_of(m_files.begin(), m_files.end(), [&](const auto& file) {
+            return std::filesystem::path(file.first).parent_path().generic_string() == it->first;
+        });
+        if (used) {
+            ++it;
+            continue;
+        }
+#if defined(FILE_WATCHER_INOTIFY)
+        if (it->second >= 0)
+            inotify_rm_watch(m_inotify, it->second);
+#endif
+        it = m_directories.erase(it);
+    }
+}
+
+void FileWatcher::readEvents() {
+#if defined(FILE_WATCHER_INOTIFY)
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        const auto length = ::read(m_inotify, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+        for (auto* ptr = buffer; ptr < buffer + length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+            if (event->len == 0)
+                continue;
+            const auto directory = std::find_if(m_directories.begin(), m_directories.end(), [&](const auto& entry) {
+                return entry.second == event->wd;
+            });
+            if (directory == m_directories.end())
+                continue;
+            const auto it = m_files.find(directory->first + '/' + event->name);
+            if (it == m_files.end())
+                continue;
+            it->second.pending = true;
+            it->second.changed = Clock::now();
+        }
+    }
+#endif
+}
+
+void FileWatcher::checkWriteTimes() {
+    const auto now = Clock::now();
+    if (now - m_last_check < CHECK_PERIOD)
+        return;
+    m_last_check = now;
+    for (auto& [path, file] : m_files) {
+        const auto time = writeTime(path);
+        if (time != file.write_time) {
+            file.write_time = time;
+            file.pending = true;
+            file.changed = now;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+// Reports the watched files that were written. Their directories are watched with inotify on Linux,
+// so that files replaced by a rename are still seen, other systems compare modification times when polled.
+// A file is reported once no write happened to it for a short delay, editors may write it in several steps.
+class FileWatcher {
+public:
+    struct Change {
+        std::string owner;
+        // as given to watch()
+        std::string path;
+    };
+
+    FileWatcher();
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // files are watched once per owner, a file stays watched until all its owners are removed
+    void watch(const std::string& owner, const std::string& path);
+    void unwatch(const std::string& owner);
+
+    // doesn't block, returns the files written since the last call, once per owner
+    auto poll() -> const std::vector<Change>&;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct File {
+        std::vector<Change> watches;
+        std::filesystem::file_time_type write_time;
+        Clock::time_point changed;
+        bool pending = false;
+    };
+    void addDirectory(const std::string& directory);
+    void removeUnusedDirectories();
+    void readEvents();
+    void checkWriteTimes();
+
+    std::map<std::string, File> m_files;
+    std::vector<Change> m_changed;
+    Clock::time_point m_last_check;
+    int m_inotify = -1;
+    // watch descriptors of the directories
+    std::map<std::string, int> m_directories;
+};
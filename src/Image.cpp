@@ -0,0 +1,58 @@
+#include "Image.hpp"
+
+#define CUTE_ASEPRITE_IMPLEMENTATION
+#include "thirdparty/cute_aseprite.h"
+
+// static, so that it doesn't clash with the copy compiled in sogl
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#include <stb_image.h>
+#define STB_IMAGE_WRITE_STATIC
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+
+bool Image::load(const std::string& path) {
+    if (std::filesystem::path(path).extension() == ".aseprite") {
+        auto* ase = cute_aseprite_load_from_file(path.c_str(), nullptr);
+        if (ase == nullptr)
+            return false;
+        width = ase->w;
+        height = ase->h;
+        const auto* frame_pixels = reinterpret_cast<const std::uint8_t*>(ase->frames[0].pixels);
+        pixels.assign(frame_pixels, frame_pixels + static_cast<std::size_t>(width) * height * 4);
+        cute_aseprite_free(ase);
+        return true;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::vector<std::uint8_t> content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return loadPNG(content.data(), content.size());
+}
+
+bool Image::loadPNG(const std::uint8_t* data, std::size_t size) {
+    if (size > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+        return false;
+    int w = 0, h = 0, channels = 0;
+    auto* decoded = stbi_load_from_memory(data, static_cast<int>(size), &w, &h, &channels, 4);
+    if (decoded == nullptr)
+        return false;
+    width = w;
+    height = h;
+    pixels.assign(decoded, decoded + static_cast<std::size_t>(width) * height * 4);
+    stbi_image_free(decoded);
+    return true;
+}
+
+bool Image::savePNG(const std::string& path) const {
+    if (width <= 0 || height <= 0 || pixels.size() != static_cast<std::size_t>(width) * height * 4)
+        return false;
+    return stbi_write_png(path.c_str(), width, height, 4, pixels.data(), width * 4) != 0;
+}
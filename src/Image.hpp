@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// RGBA8 image decoded on the CPU, from a .png or an .aseprite file
+struct Image {
+    bool load(const std::string& path);
+    // decodes a PNG file content with stb_image, any color type and bit depth is converted to RGBA8
+    bool loadPNG(const std::uint8_t* data, std::size_t size);
+    // writes an RGBA PNG file with stb_image_write
+    bool savePNG(const std::string& path) const;
+
+    int width = 0;
+    int height = 0;
+    std::vector<std::uint8_t> pixels;
+};
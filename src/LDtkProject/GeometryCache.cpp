@@ -0,0 +1,218 @@
+#include "GeometryCache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    using Quad = LDtkProjectObjects::Quad;
+
+    constexpr char magic[4] = {'L', 'D', 'V', 'G'};
+    constexpr std::uint32_t version = 2;
+    constexpr auto extension = ".geom";
+
+    struct Header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t vertex_size;
+        std::uint32_t layers_count;
+        std::uint64_t key;
+    };
+
+    // tiles quads then entities quads, at offset bytes from the start of the file
+    struct LayerEntry {
+        std::uint32_t tiles_count;
+        std::uint32_t entities_count;
+        std::uint64_t offset;
+    };
+}
+
+GeometryCache::GeometryCache(std::string directory, std::uint64_t tilesets_key) :
+m_directory(std::move(directory)), m_tilesets_key(tilesets_key)
+{}
+
+std::uint64_t GeometryCache::hash(const void* data, std::size_t size, std::uint64_t seed) {
+    // FNV-1a
+    const auto* bytes = static_cast<const std::uint8_t*>(data);
+    auto result = seed;
+    for (std::size_t i = 0; i < size; ++i) {
+        result ^= bytes[i];
+        result *= 0x100000001b3;
+    }
+    return result;
+}
+
+std::uint64_t GeometryCache::keyOf(const ldtk::Project& project, const std::string& directory) {
+    auto key = hash(nullptr, 0);
+    for (const auto& tileset : project.allTilesets()) {
+        if (tileset.path.empty())
+            continue;
+        const auto path = directory + tileset.path;
+        std::error_code error;
+        const auto size = static_cast<std::uint64_t>(std::filesystem::file_size(path, error));
+        const auto time = static_cast<std::int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+        key = hash(path.data(), path.size(), key);
+        key = hash(&size, sizeof(size), key);
+        key = hash(&time, sizeof(time), key);
+    }
+    return key;
+}
+
+std::string GeometryCache::directory() {
+#if defined(EMSCRIPTEN)
+    return {};
+#elif defined(_WIN32)
+    if (const auto* local = std::getenv("LOCALAPPDATA"))
+        return std::string(local) + "/LDtkViewer/cache";
+    return {};
+#else
+    const auto* home = std::getenv("HOME");
+    #if defined(__APPLE__)
+    if (home != nullptr)
+        return std::string(home) + "/Library/Caches/LDtkViewer";
+    #else
+    if (const auto* xdg = std::getenv("XDG_CACHE_HOME"); xdg != nullptr && xdg[0] != '\0')
+        return std::string(xdg) + "/LDtkViewer";
+    if (home != nullptr)
+        return std::string(home) + "/.cache/LDtkViewer";
+    #endif
+    return {};
+#endif
+}
+
+void GeometryCache::prune(const std::string& directory, std::uintmax_t max_size) {
+    struct File {
+        std::filesystem::path path;
+        std::uintmax_t size;
+        std::filesystem::file_time_type time;
+    };
+    std::vector<File> files;
+    std::uintmax_t total_size = 0;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (!entry.is_regular_file(error) || entry.path().extension() != extension)
+            continue;
+        const auto size = entry.file_size(error);
+        const auto time = entry.last_write_time(error);
+        if (error)
+            continue;
+        files.push_back({entry.path(), size, time});
+        total_size += size;
+    }
+    if (total_size <= max_size)
+        return;
+    // the files read are touched, the oldest ones are the least recently used
+    std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.time < b.time; });
+    for (const auto& file : files) {
+        if (total_size <= max_size)
+            break;
+        if (std::filesystem::remove(file.path, error))
+            total_size -= file.size;
+    }
+}
+
+std::uint64_t GeometryCache::keyOf(const LDtkProjectObjects::Level& level) const {
+    // the quads are in world coordinates, the position of the levels of linear worlds is not in their content
+    const auto key = hash(&level.content_hash, sizeof(level.content_hash), m_tilesets_key);
+    const float position[] = {level.bounds.pos.x, level.bounds.pos.y};
+    return hash(position, sizeof(position), key);
+}
+
+std::string GeometryCache::pathFor(const LDtkProjectObjects::Level& level) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx%s", static_cast<unsigned long long>(keyOf(level)), extension);
+    return m_directory + "/" + name;
+}
+
+bool GeometryCache::write(const LDtkProjectObjects::Level& level) const {
+    // one vector per layer, tiles then entities
+    std::vector<std::vector<Quad>> quads(level.layers.size() * 2);
+    for (std::size_t l = 0; l < level.layers.size(); ++l) {
+        LDtkProjectObjects::Layer::buildTilesQuads(level.layers[l].data, level.bounds.pos, quads[l * 2]);
+        LDtkProjectObjects::Layer::buildEntitiesQuads(level.layers[l].data, level.bounds.pos, quads[l * 2 + 1]);
+    }
+
+    std::vector<LayerEntry> entries;
+    for (std::size_t l = 0; l < quads.size(); l += 2)
+        entries.push_back({static_cast<std::uint32_t>(quads[l].size()), static_cast<std::uint32_t>(quads[l + 1].size()), 0});
+    auto offset = static_cast<std::uint64_t>(sizeof(Header) + entries.size() * sizeof(LayerEntry));
+    for (auto& entry : entries) {
+        entry.offset = offset;
+        offset += (static_cast<std::uint64_t>(entry.tiles_count) + entry.entities_count) * sizeof(Quad);
+    }
+
+    const auto path = pathFor(level);
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+    // written aside and renamed, so that a partially written file is never read
+    const auto temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary);
+        if (!file)
+            return false;
+        Header header = {{}, version, sizeof(sogl::Vertex), static_cast<std::uint32_t>(entries.size()), keyOf(level)};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(LayerEntry)));
+        for (const auto& layer_quads : quads)
+            file.write(reinterpret_cast<const char*>(layer_quads.data()), static_cast<std::streamsize>(layer_quads.size() * sizeof(Quad)));
+        if (!file)
+            return false;
+    }
+    std::filesystem::rename(temp_path, path, error);
+    return !error;
+}
+
+bool GeometryCache::read(const LDtkProjectObjects::Level& level) {
+    const auto path = pathFor(level);
+    auto file = std::make_unique<MappedFile>();
+    if (!file->open(path) || file->size() < sizeof(Header)) {
+        m_misses++;
+        return false;
+    }
+    const auto* data = file->data();
+    const auto size = file->size();
+
+    Header header{};
+    std::memcpy(&header, data, sizeof(header));
+    const auto layers_count = level.layers.size();
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version || header.key != keyOf(level)
+        || header.vertex_size != sizeof(sogl::Vertex) || header.layers_count != layers_count
+        || size < sizeof(Header) + layers_count * sizeof(LayerEntry)) {
+        m_misses++;
+        return false;
+    }
+
+    const auto* entries = reinterpret_cast<const LayerEntry*>(data + sizeof(Header));
+    for (std::size_t i = 0; i < layers_count; ++i) {
+        const auto end = entries[i].offset + (static_cast<std::uint64_t>(entries[i].tiles_count) + entries[i].entities_count) * sizeof(Quad);
+        if (end > size || entries[i].offset % alignof(Quad) != 0) {
+            m_misses++;
+            return false;
+        }
+    }
+
+    for (std::size_t i = 0; i < layers_count; ++i) {
+        const auto* tiles = reinterpret_cast<const Quad*>(data + entries[i].offset);
+        level.layers[i].setCachedGeometry(tiles, entries[i].tiles_count, tiles + entries[i].tiles_count, entries[i].entities_count);
+    }
+    // used files are kept when the directory is pruned
+    std::error_code error;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+    m_hits++;
+
+    std::lock_guard lock(m_mutex);
+    m_files.push_back(std::move(file));
+    return true;
+}
+
+std::size_t GeometryCache::getHitsCount() const {
+    return m_hits;
+}
+
+std::size_t GeometryCache::getMissesCount() const {
+    return m_misses;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "LDtkProjectObjects.hpp"
+#include "MappedFile.hpp"
+
+#include <LDtkLoader/Project.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Persistent cache of the layers geometry, one binary file per level in the user cache directory.
+// Files are keyed by a hash of the level content and position, and of the tilesets metadata. The geometry of a level is read,
+// or built and written, the first time the level is built: the file is mapped in memory and used by its layers.
+class GeometryCache {
+public:
+    // the least recently used files are removed above this size
+    static constexpr std::uintmax_t max_directory_size = std::uintmax_t(256) * 1024 * 1024;
+
+    // tilesets_key is the key of the tilesets of the project, see keyOf()
+    GeometryCache(std::string directory, std::uint64_t tilesets_key);
+    GeometryCache(const GeometryCache&) = delete;
+    GeometryCache& operator=(const GeometryCache&) = delete;
+
+    static std::uint64_t hash(const void* data, std::size_t size, std::uint64_t seed = 0xcbf29ce484222325);
+    static std::uint64_t keyOf(const ldtk::Project& project, const std::string& directory);
+    // user cache directory of the viewer, empty when there is none
+    static std::string directory();
+    // removes the least recently used files of the directory until its size is at most max_size
+    static void prune(const std::string& directory, std::uintmax_t max_size);
+
+    // maps the cache file of the level and hands its geometry to the layers, false if missing or not matching.
+    // Can be called from any thread for different levels, the cache must outlive the levels rendering
+    bool read(const LDtkProjectObjects::Level& level);
+    // builds the geometry of all the layers of the level and writes it to its cache file
+    bool write(const LDtkProjectObjects::Level& level) const;
+
+    std::size_t getHitsCount() const;
+    std::size_t getMissesCount() const;
+
+private:
+    std::string pathFor(const LDtkProjectObjects::Level& level) const;
+    std::uint64_t keyOf(const LDtkProjectObjects::Level& level) const;
+
+    std::string m_directory;
+    std::uint64_t m_tilesets_key;
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<MappedFile>> m_files;
+    std::atomic<std::size_t> m_hits = 0;
+    std::atomic<std::size_t> m_misses = 0;
+};
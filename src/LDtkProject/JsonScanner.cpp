@@ -0,0 +1,222 @@
+#include "JsonScanner.hpp"
+
+namespace {
+    constexpr auto npos = std::string_view::npos;
+
+    void appendUtf8(std::string& out, unsigned code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    // the 4 hex digits of a \u escape starting at pos, false if they are missing or invalid
+    bool parseHex4(std::string_view text, std::size_t pos, unsigned& code) {
+        if (pos + 4 > text.size())
+            return false;
+        code = 0;
+        for (std::size_t i = pos; i < pos + 4; ++i) {
+            const auto c = text[i];
+            code <<= 4;
+            if (c >= '0' && c <= '9')
+                code |= static_cast<unsigned>(c - '0');
+            else if (c >= 'a' && c <= 'f')
+                code |= static_cast<unsigned>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F')
+                code |= static_cast<unsigned>(c - 'A' + 10);
+            else
+                return false;
+        }
+        return true;
+    }
+}
+
+JsonScanner::JsonScanner(std::string_view text) : m_text(text) {
+    // the root members are located once, most lookups are made in the root object
+    const auto begin = skipWhitespace(0);
+    m_root = {begin, skipValue(begin)};
+    if (!m_root.found() || m_root.end == npos || m_text[m_root.begin] != '{')
+        return;
+    auto pos = skipWhitespace(m_root.begin + 1);
+    while (pos < m_root.end && m_text[pos] == '"') {
+        const auto key_end = skipString(pos);
+        if (key_end == npos)
+            return;
+        const auto name = m_text.substr(pos + 1, key_end - pos - 2);
+        pos = skipWhitespace(key_end);
+        if (pos >= m_root.end || m_text[pos] != ':')
+            return;
+        const auto value_begin = skipWhitespace(pos + 1);
+        const auto value_end = skipValue(value_begin);
+        if (value_end == npos)
+            return;
+        m_root_members.emplace_back(name, Span{value_begin, value_end});
+        pos = skipWhitespace(value_end);
+        if (pos < m_root.end && m_text[pos] == ',')
+            pos = skipWhitespace(pos + 1);
+    }
+}
+
+auto JsonScanner::member(std::string_view key) const -> Span {
+    for (const auto& [name, span] : m_root_members) {
+        if (name == key)
+            return span;
+    }
+    return {};
+}
+
+auto JsonScanner::member(std::string_view key, const Span& object) const -> Span {
+    if (!object.found() || object.end == npos || m_text[object.begin] != '{')
+        return {};
+
+    auto pos = skipWhitespace(object.begin + 1);
+    while (pos < object.end && m_text[pos] == '"') {
+        const auto key_end = skipString(pos);
+        if (key_end == npos)
+            return {};
+        const auto name = m_text.substr(pos + 1, key_end - pos - 2);
+
+        pos = skipWhitespace(key_end);
+        if (pos >= object.end || m_text[pos] != ':')
+            return {};
+        const auto value_begin = skipWhitespace(pos + 1);
+        const auto value_end = skipValue(value_begin);
+        if (value_end == npos)
+            return {};
+        // keys are compared without unescaping, LDtk keys never contain escape sequences
+        if (name == key)
+            return {value_begin, value_end};
+
+        pos = skipWhitespace(value_end);
+        if (pos < object.end && m_text[pos] == ',')
+            pos = skipWhitespace(pos + 1);
+    }
+    return {};
+}
+
+auto JsonScanner::elements(const Span& array) const -> std::vector<Span> {
+    std::vector<Span> result;
+    if (!array.found() || array.end == npos || m_text[array.begin] != '[')
+        return result;
+
+    auto pos = skipWhitespace(array.begin + 1);
+    while (pos < array.end && m_text[pos] != ']') {
+        const auto value_end = skipValue(pos);
+        if (value_end == npos)
+            break;
+        result.push_back({pos, value_end});
+        pos = skipWhitespace(value_end);
+        if (pos < array.end && m_text[pos] == ',')
+            pos = skipWhitespace(pos + 1);
+    }
+    return result;
+}
+
+std::string_view JsonScanner::view(const Span& span) const {
+    if (!span.found() || span.end == npos)
+        return {};
+    return m_text.substr(span.begin, span.end - span.begin);
+}
+
+std::string JsonScanner::string(const Span& span) const {
+    std::string result;
+    const auto text = view(span);
+    if (text.size() < 2 || text.front() != '"')
+        return result;
+
+    result.reserve(text.size() - 2);
+    // the end quote is not part of the escape sequences
+    const auto content = text.substr(0, text.size() - 1);
+    for (std::size_t i = 1; i + 1 < text.size(); ++i) {
+        if (text[i] != '\\' || i + 2 >= text.size()) {
+            result += text[i];
+            continue;
+        }
+        switch (text[++i]) {
+            case 'n': result += '\n'; break;
+            case 't': result += '\t'; break;
+            case 'r': result += '\r'; break;
+            case 'b': result += '\b'; break;
+            case 'f': result += '\f'; break;
+            case 'u': {
+                // malformed escapes make the whole string unreadable
+                unsigned code = 0;
+                if (!parseHex4(content, i + 1, code) || (code >= 0xDC00 && code <= 0xDFFF))
+                    return {};
+                i += 4;
+                // characters outside of the BMP are escaped as a pair of surrogates
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    unsigned low = 0;
+                    if (i + 2 >= content.size() || content[i + 1] != '\\' || content[i + 2] != 'u'
+                        || !parseHex4(content, i + 3, low) || low < 0xDC00 || low > 0xDFFF)
+                        return {};
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                }
+                appendUtf8(result, code);
+                break;
+            }
+            default: result += text[i]; break;
+        }
+    }
+    return result;
+}
+
+std::size_t JsonScanner::skipWhitespace(std::size_t pos) const {
+    while (pos < m_text.size() && (m_text[pos] == ' ' || m_text[pos] == '\n' || m_text[pos] == '\r' || m_text[pos] == '\t'))
+        pos++;
+    return pos;
+}
+
+std::size_t JsonScanner::skipString(std::size_t pos) const {
+    for (pos = pos + 1; pos < m_text.size(); ++pos) {
+        if (m_text[pos] == '\\')
+            pos++;
+        else if (m_text[pos] == '"')
+            return pos + 1;
+    }
+    return npos;
+}
+
+std::size_t JsonScanner::skipValue(std::size_t pos) const {
+    if (pos >= m_text.size())
+        return npos;
+
+    if (m_text[pos] == '"')
+        return skipString(pos);
+
+    if (m_text[pos] == '{' || m_text[pos] == '[') {
+        // strings are skipped as a whole, so that brackets inside them are not counted
+        int nesting = 0;
+        while (pos < m_text.size()) {
+            const auto c = m_text[pos];
+            if (c == '"') {
+                pos = skipString(pos);
+                if (pos == npos)
+                    return npos;
+                continue;
+            }
+            if (c == '{' || c == '[')
+                nesting++;
+            else if ((c == '}' || c == ']') && --nesting == 0)
+                return pos + 1;
+            pos++;
+        }
+        return npos;
+    }
+
+    // numbers, booleans and null
+    const auto end = m_text.find_first_of(",}] \n\r\t", pos);
+    return end == npos ? m_text.size() : end;
+}
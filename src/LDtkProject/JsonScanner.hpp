@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Locates values in a JSON document without building it, so that only the needed parts have to be parsed.
+// Malformed documents are not reported, the values that cannot be reached are simply not found.
+class JsonScanner {
+public:
+    struct Span {
+        std::size_t begin = std::string_view::npos;
+        std::size_t end = std::string_view::npos;
+        bool found() const { return begin != std::string_view::npos; }
+    };
+
+    explicit JsonScanner(std::string_view text);
+
+    // value of a member of the object spanning over `object`, the root value by default (its members are located
+    // once, when the scanner is built)
+    Span member(std::string_view key) const;
+    Span member(std::string_view key, const Span& object) const;
+    // values of the array spanning over `array`
+    std::vector<Span> elements(const Span& array) const;
+
+    std::string_view view(const Span& span) const;
+    // unescaped content of a string value, empty if the value is not a string
+    std::string string(const Span& span) const;
+
+private:
+    std::size_t skipWhitespace(std::size_t pos) const;
+    std::size_t skipString(std::size_t pos) const;
+    std::size_t skipValue(std::size_t pos) const;
+
+    std::string_view m_text;
+    Span m_root;
+    std::vector<std::pair<std::string_view, Span>> m_root_members;
+};
@@ -1,31 +1,309 @@
 // Created by Modar Nasser on 18/03/2022.
 
 #include "LDtkProject.hpp"
+#include "JsonScanner.hpp"
+#include "MappedFile.hpp"
+#include "Profiler.hpp"
+#include "TextureManager.hpp"
+#include "ThreadPool.hpp"
 
-#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // copy of the project file without the members the viewer doesn't use
+    std::string stripUnusedMembers(std::string_view text) {
+        // members the loader doesn't read, emptied so that they are not parsed: auto-layers rules,
+        // tilesets pixels data and selections, and the table of contents of recent LDtk versions
+        const JsonScanner scanner(text);
+        std::vector<JsonScanner::Span> unused;
+        const auto defs = scanner.member("defs");
+        for (const auto& layer : scanner.elements(scanner.member("layers", defs)))
+            unused.push_back(scanner.member("autoRuleGroups", layer));
+        for (const auto& tileset : scanner.elements(scanner.member("tilesets", defs))) {
+            unused.push_back(scanner.member("cachedPixelData", tileset));
+            unused.push_back(scanner.member("savedSelections", tileset));
+        }
+        unused.push_back(scanner.member("toc"));
+        unused.erase(std::remove_if(unused.begin(), unused.end(), [&](const JsonScanner::Span& span) {
+            if (!span.found() || span.end == std::string_view::npos)
+                return true;
+            const auto open = text[span.begin];
+            return open != '[' && open != '{' && open != '"';
+        }), unused.end());
+        std::sort(unused.begin(), unused.end(), [](const JsonScanner::Span& a, const JsonScanner::Span& b) {
+            return a.begin < b.begin;
+        });
+
+        auto size = text.size();
+        for (const auto& span : unused)
+            size -= span.end - span.begin - 2;
+
+        std::string document;
+        document.reserve(size);
+        std::size_t pos = 0;
+        for (const auto& span : unused) {
+            document.append(text.substr(pos, span.begin - pos));
+            // replaced by an empty value of the same type
+            const auto open = text[span.begin];
+            document.push_back(open);
+            document.push_back(open == '[' ? ']' : open == '{' ? '}' : open);
+            pos = span.end;
+        }
+        document.append(text.substr(pos));
+        return document;
+    }
+
+    // Projects with external levels are loaded without their levels content, which is streamed later.
+    // Multi-worlds projects are loaded entirely, their levels being spread over several arrays.
+    bool makeStreamingHeader(const JsonScanner& scanner, std::string_view text, std::string& header,
+                             std::vector<std::string>& levels_paths) {
+        if (scanner.view(scanner.member("externalLevels")) != "true" || !scanner.elements(scanner.member("worlds")).empty())
+            return false;
+
+        // the header is parsed again with each level, it is stripped of the members the loader doesn't read
+        const auto document = stripUnusedMembers(text);
+        const std::string_view stripped(document);
+        const auto external_levels = JsonScanner(stripped).member("externalLevels");
+        header.reserve(stripped.size());
+        header.append(stripped.substr(0, external_levels.begin)).append("false").append(stripped.substr(external_levels.end));
+
+        const JsonScanner header_scanner(header);
+        for (const auto& level : header_scanner.elements(header_scanner.member("levels")))
+            levels_paths.push_back(header_scanner.string(header_scanner.member("externalRelPath", level)));
+        return true;
+    }
+
+    // paths of the external levels files of all the worlds
+    std::vector<std::string> findLevelsFiles(const JsonScanner& scanner, const std::string& directory) {
+        std::vector<JsonScanner::Span> levels_arrays;
+        for (const auto& world : scanner.elements(scanner.member("worlds")))
+            levels_arrays.push_back(scanner.member("levels", world));
+        levels_arrays.push_back(scanner.member("levels"));
+
+        std::vector<std::string> result;
+        for (const auto& levels : levels_arrays) {
+            for (const auto& level : scanner.elements(levels)) {
+                const auto relative_path = scanner.string(scanner.member("externalRelPath", level));
+                if (!relative_path.empty())
+                    result.push_back(directory + relative_path);
+            }
+        }
+        return result;
+    }
+
+    struct LevelHashes {
+        std::uint64_t level = 0;
+        std::vector<std::uint64_t> layers;
+    };
+
+    // hashes of the levels and layers JSON, per world in the order of the loaded levels.
+    // The definitions are part of every hash, since the levels are drawn from them.
+    std::vector<std::vector<LevelHashes>> hashLevels(const JsonScanner& scanner) {
+        const auto definitions = scanner.view(scanner.member("defs"));
+        const auto seed = GeometryCache::hash(definitions.data(), definitions.size());
+        auto hash = [&](const JsonScanner::Span& span) {
+            const auto json = scanner.view(span);
+            return GeometryCache::hash(json.data(), json.size(), seed);
+        };
+
+        std::vector<JsonScanner::Span> levels_arrays;
+        for (const auto& world : scanner.elements(scanner.member("worlds")))
+            levels_arrays.push_back(scanner.member("levels", world));
+        if (levels_arrays.empty())
+            levels_arrays.push_back(scanner.member("levels"));
+
+        std::vector<std::vector<LevelHashes>> result;
+        for (const auto& levels : levels_arrays) {
+            auto& world_hashes = result.emplace_back();
+            for (const auto& level : scanner.elements(levels)) {
+                auto& level_hashes = world_hashes.emplace_back();
+                level_hashes.level = hash(level);
+                for (const auto& layer : scanner.elements(scanner.member("layerInstances", level)))
+                    level_hashes.layers.push_back(hash(layer));
+            }
+        }
+        return result;
+    }
+}
 
 bool LDtkProject::load(const char* a_path) {
+    if (!loadData(a_path))
+        return false;
+    upload();
+    return true;
+}
+
+bool LDtkProject::loadData(const char* a_path, const std::function<void(float)>& on_progress) {
+    // rough share of the loading time taken by each stage
+    constexpr auto parse_share = 0.3f;
+    constexpr auto build_share = 0.5f;
+    constexpr auto decode_share = 1.f - parse_share - build_share;
+    auto progress = [&](float value) {
+        if (on_progress)
+            on_progress(value);
+    };
+
+    // the file is only scanned to find the streamed levels and hash the levels, without building a DOM.
+    // It is released before the loader parses it, straight from the file (LDtkLoader can only build its
+    // DOM from a stream or from a copy of the document), so that the parsing doesn't hold a second copy of it
+    Profiler::resetPeakMemory();
+    auto start = Clock::now();
+    MappedFile file;
+    if (!(map_file ? file.open(a_path, true) : file.read(a_path))) {
+        std::cout << "Failed to open " << a_path << std::endl;
+        return false;
+    }
+    const auto text = file.view();
+    const JsonScanner scanner(text);
+    std::string header;
+    std::vector<std::string> levels_paths;
+    const auto streaming = makeStreamingHeader(scanner, text, header, levels_paths);
+    // levels of multi-worlds projects are found by the loader next to the project file
+    const auto external_levels = !streaming && scanner.view(scanner.member("externalLevels")) == "true";
+    const auto directory = LDtkProjectObjects::directoryOf(a_path);
+    if (streaming || external_levels)
+        levels_files = findLevelsFiles(scanner, directory);
+    std::vector<std::vector<LevelHashes>> level_hashes;
+    if (!streaming && !external_levels)
+        level_hashes = hashLevels(scanner);
+    timings.file_size = file.size();
+    file.close();
+    timings.read_ms = elapsedMs(start);
+
+    start = Clock::now();
     auto* project = new ldtk::Project();
     try {
-        project->loadFromFile(a_path);
+        if (streaming)
+            project->loadFromMemory(std::vector<std::uint8_t>(header.begin(), header.end()));
+        else
+            project->loadFromFile(a_path);
     } catch(std::exception& ex) {
         std::cout << ex.what() << std::endl;
         delete project;
         return false;
     }
+    progress(parse_share);
+    timings.parse_ms = elapsedMs(start);
+    timings.peak_memory_kib = Profiler::getPeakMemoryKiB();
 
     data = std::unique_ptr<ldtk::Project>(project);
-    path = std::string(data->getFilePath().c_str());
+    path = a_path;
+
+    std::size_t levels_count = 0;
+    for (const auto& world : data->allWorlds())
+        levels_count += world.allLevels().size();
+    std::atomic<std::size_t> levels_built = 0;
+    auto on_level_built = [&] {
+        progress(parse_share + build_share * static_cast<float>(++levels_built) / static_cast<float>(levels_count));
+    };
 
+    start = Clock::now();
+    auto& pool = ThreadPool::global();
     objects = std::make_unique<LDtkProjectObjects>();
-    objects->name = data->getFilePath().filename();
+    objects->name = std::filesystem::path(path).filename().string();
     for (const auto& world : data->allWorlds())
-        objects->worlds.emplace_back(world, project->getFilePath());
+        objects->worlds.emplace_back(world, path, pool, on_level_built);
+    objects->indexIids();
+    timings.build_ms = elapsedMs(start);
+    timings.threads = std::max(1u, pool.getThreadsCount());
+
+    // used to find the levels that didn't change when the project is reloaded
+    for (std::size_t w = 0; w < level_hashes.size() && w < objects->worlds.size(); ++w) {
+        auto& world = objects->worlds[w];
+        const auto& all_levels = world.data.allLevels();
+        for (auto& [_, depth_levels] : world.levels) {
+            for (auto& level : depth_levels) {
+                const auto index = static_cast<std::size_t>(&level.data - all_levels.data());
+                if (index >= level_hashes[w].size() || level_hashes[w][index].layers.size() != level.layers.size())
+                    continue;
+                level.content_hash = level_hashes[w][index].level;
+                for (std::size_t l = 0; l < level.layers.size(); ++l)
+                    level.layers[l].content_hash = level_hashes[w][index].layers[l];
+            }
+        }
+    }
+
+    // levels whose hash is known use the cache when they are built, streamed levels are not cached
+    start = Clock::now();
+    const auto cache_directory = use_geometry_cache ? GeometryCache::directory() : std::string();
+    if (!cache_directory.empty()) {
+        GeometryCache::prune(cache_directory, GeometryCache::max_directory_size);
+        geometry_cache = std::make_unique<GeometryCache>(cache_directory, GeometryCache::keyOf(*data, directory));
+        for (auto& world : objects->worlds) {
+            for (auto& [_, depth_levels] : world.levels) {
+                for (auto& level : depth_levels) {
+                    if (level.content_hash != 0)
+                        level.geometry_cache = geometry_cache.get();
+                }
+            }
+        }
+    }
+    timings.cache_ms = elapsedMs(start);
+
+    start = Clock::now();
+    search_index = std::make_unique<SearchIndex>(*objects);
+    timings.index_ms = elapsedMs(start);
+
     selected_world = &objects->worlds[0];
     selected_level = &selected_world->levels.at(0)[0];
+
+    // every tileset of the definitions, so that streamed levels find their textures loaded,
+    // except the ones reused from a previous version of the project
+    for (const auto& tileset : data->allTilesets())
+        if (!tileset.path.empty())
+            tilesets_images[directory + tileset.path];
+    for (const auto& texture : textures)
+        tilesets_images.erase(texture.getName());
+    if (streaming)
+        streamer = std::make_unique<LevelStreamer>(header, directory, *objects, levels_paths);
+
+    start = Clock::now();
+    const auto images_count = static_cast<float>(tilesets_images.size());
+    TextureManager::prefetch(tilesets_images, pool, [&](std::size_t decoded) {
+        progress(parse_share + build_share + decode_share * static_cast<float>(decoded) / images_count);
+    });
+    timings.decode_ms = elapsedMs(start);
+    progress(1.f);
     return true;
 }
 
+void LDtkProject::search() {
+    search_results.clear();
+    search_matches = 0;
+    if (search_index != nullptr)
+        search_matches = search_index->query(search_text.data(), search_results, max_search_results);
+}
+
+void LDtkProject::upload() {
+    const auto start = Clock::now();
+    textures.reserve(textures.size() + tilesets_images.size());
+    for (const auto& [image_path, image] : tilesets_images)
+        textures.push_back(TextureManager::load(image_path, image));
+    tilesets_images.clear();
+    timings.upload_ms = elapsedMs(start);
+}
+
+void LDtkProject::reuseTextures(const LDtkProject& previous) {
+    textures = previous.textures;
+}
+
+std::size_t LDtkProject::getTexturesMemory() const {
+    std::size_t memory = 0;
+    for (const auto& texture : textures)
+        memory += texture.getMemory();
+    return memory;
+}
+
 std::string LDtkProject::fieldTypeEnumToString(const ldtk::FieldType& type) {
     switch (type) {
         case ldtk::FieldType::Int:
@@ -93,124 +371,3 @@ bool LDtkProject::fieldTypeIsArray(const ldtk::FieldType& type) {
     }
     return false;
 }
-
-std::vector<std::string> LDtkProject::fieldValuesToString(const ldtk::FieldDef& def, const ldtk::Entity& entity) {
-    std::stringstream stream;
-    std::vector<std::string> values;
-    switch (def.type) {
-        case ldtk::FieldType::Int:
-            stream << entity.getField<ldtk::FieldType::Int>(def.name);
-            values.push_back(stream.str());
-            break;
-        case ldtk::FieldType::Float:
-            stream << entity.getField<ldtk::FieldType::Float>(def.name);
-            values.push_back(stream.str());
-            break;
-        case ldtk::FieldType::Bool:
-            stream << std::boolalpha << entity.getField<ldtk::FieldType::Bool>(def.name);
-            values.push_back(stream.str());
-            break;
-        case ldtk::FieldType::String:
-            stream << entity.getField<ldtk::FieldType::String>(def.name);
-            values.push_back(stream.str());
-            break;
-        case ldtk::FieldType::Color:
-            stream << entity.getField<ldtk::FieldType::Color>(def.name);
-            values.push_back(stream.str());
-            break;
-        case ldtk::FieldType::Point:
-            stream << entity.getField<ldtk::FieldType::Point>(def.name);
-            values.push_back(stream.str());
-            break;
-        case ldtk::FieldType::Enum:
-            stream << entity.getField<ldtk::FieldType::Enum>(def.name);
-            values.push_back(stream.str());
-            break;
-        case ldtk::FieldType::FilePath:
-            stream << entity.getField<ldtk::FieldType::FilePath>(def.name);
-            values.push_back(stream.str());
-            break;
-        case ldtk::FieldType::EntityRef: {
-            const auto& field = entity.getField<ldtk::FieldType::EntityRef>(def.name);
-            stream << entity.getName() << "->";
-            if (field.is_null()) {
-                stream << "null";
-            } else {
-                const auto& val = field.value();
-                stream << val->getName();
-            }
-            values.push_back(stream.str());
-            break;
-        }
-        case ldtk::FieldType::ArrayInt:
-            for (const auto& field : entity.getField<ldtk::FieldType::ArrayInt>(def.name)) {
-                stream << field;
-                values.push_back(stream.str());
-                stream.str("");
-            }
-            break;
-        case ldtk::FieldType::ArrayFloat:
-            for (const auto& field : entity.getField<ldtk::FieldType::ArrayFloat>(def.name)) {
-                stream << field;
-                values.push_back(stream.str());
-                stream.str("");
-            }
-            break;
-        case ldtk::FieldType::ArrayBool:
-            for (const auto& field : entity.getField<ldtk::FieldType::ArrayBool>(def.name)) {
-                stream << std::boolalpha << field;
-                values.push_back(stream.str());
-                stream.str("");
-            }
-            break;
-        case ldtk::FieldType::ArrayString:
-            for (const auto& field : entity.getField<ldtk::FieldType::ArrayString>(def.name)) {
-                stream << field;
-                values.push_back(stream.str());
-                stream.str("");
-            }
-            break;
-        case ldtk::FieldType::ArrayColor:
-            for (const auto& field : entity.getField<ldtk::FieldType::ArrayColor>(def.name)) {
-                stream << field;
-                values.push_back(stream.str());
-                stream.str("");
-            }
-            break;
-        case ldtk::FieldType::ArrayPoint:
-            for (const auto& field : entity.getField<ldtk::FieldType::ArrayPoint>(def.name)) {
-                stream << field;
-                values.push_back(stream.str());
-                stream.str("");
-            }
-            break;
-        case ldtk::FieldType::ArrayEnum:
-            for (const auto& field : entity.getField<ldtk::FieldType::ArrayEnum>(def.name)) {
-                stream << field;
-                values.push_back(stream.str());
-                stream.str("");
-            }
-            break;
-        case ldtk::FieldType::ArrayFilePath:
-            for (const auto& field : entity.getField<ldtk::FieldType::ArrayFilePath>(def.name)) {
-                stream << field;
-                values.push_back(stream.str());
-                stream.str("");
-            }
-            break;
-        case ldtk::FieldType::ArrayEntityRef:
-            for (const auto& field : entity.getField<ldtk::FieldType::ArrayEntityRef>(def.name)) {
-                stream << entity.getName() << "->";
-                if (field.is_null()) {
-                    stream << "null";
-                } else {
-                    const auto& val = field.value();
-                    stream << val->getName();
-                }
-                values.push_back(stream.str());
-                stream.str("");
-            }
-            break;
-    }
-    return values;
-}
@@ -3,32 +3,91 @@
 #pragma once
 
 #include "Camera2D.hpp"
+#include "GeometryCache.hpp"
+#include "Image.hpp"
 #include "LDtkProjectObjects.hpp"
+#include "LevelStreamer.hpp"
+#include "SearchIndex.hpp"
+#include "TextureManager.hpp"
 
 #include <LDtkLoader/Project.hpp>
 
+#include <array>
+#include <functional>
+#include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
+struct LoadTimings {
+    double read_ms = 0;
+    double parse_ms = 0;
+    double build_ms = 0;
+    double decode_ms = 0;
+    double upload_ms = 0;
+    double cache_ms = 0;
+    double index_ms = 0;
+    unsigned threads = 0;
+    std::size_t file_size = 0;
+    // peak resident memory of the process while the project was read and parsed, 0 when unknown
+    long peak_memory_kib = 0;
+};
+
 struct LDtkProject {
 public:
     bool load(const char* path);
+    // parsing, geometry building and images decoding, can run on any thread
+    // projects with external levels are loaded in streaming mode: only the levels index is parsed here,
+    // the levels content is loaded by the streamer when requested
+    bool loadData(const char* path, const std::function<void(float)>& on_progress = {});
+    // textures upload, must run on the GL thread (levels geometry is uploaded lazily when visible)
+    void upload();
+    // keeps the textures of a previous version of the project, they are not decoded again by loadData()
+    // (changed tilesets are reloaded by the App when their files are written)
+    void reuseTextures(const LDtkProject& previous);
+    // memory of the textures used by the project, including the ones shared with other projects
+    std::size_t getTexturesMemory() const;
+    // runs the query of search_text on the search index
+    void search();
     static std::string fieldTypeEnumToString(const ldtk::FieldType& type);
     static bool fieldTypeIsArray(const ldtk::FieldType& type);
-    static std::vector<std::string> fieldValuesToString(const ldtk::FieldDef& def, const ldtk::Entity& entity);
 
     Camera2D camera;
-    int depth;
+    int depth = 0;
     std::string path;
     bool render_entities = false;
+    bool render_intgrid = true;
 
     const LDtkProjectObjects::World* selected_world = nullptr;
     const LDtkProjectObjects::Level* selected_level = nullptr;
     const LDtkProjectObjects::Entity* selected_entity = nullptr;
     const LDtkProjectObjects::Field* selected_field = nullptr;
-    std::vector<std::string> selected_field_values;
+
+    // text of the search box and the first documents it matches
+    static constexpr std::size_t max_search_results = 1000;
+    std::array<char, 128> search_text = {};
+    std::vector<SearchIndex::Document> search_results;
+    std::size_t search_matches = 0;
+
+    // layers geometry is read from the user cache directory when their level didn't change
+    bool use_geometry_cache = true;
+    // the project file is mapped, unless it may be rewritten while being loaded (reloads)
+    bool map_file = true;
+    // .ldtkl files of the levels saved separately from the project, empty when there are none
+    std::vector<std::string> levels_files;
 
     std::unique_ptr<ldtk::Project> data = nullptr;
+    std::unique_ptr<GeometryCache> geometry_cache = nullptr;
     std::unique_ptr<LDtkProjectObjects> objects = nullptr;
+    std::unique_ptr<SearchIndex> search_index = nullptr;
+    // null unless the project is loaded in streaming mode, destroyed first since it fills objects
+    std::unique_ptr<LevelStreamer> streamer = nullptr;
+
+    LoadTimings timings;
+
+    // decoded tilesets, waiting for upload()
+    std::map<std::string, Image> tilesets_images;
+    // tilesets textures, released with the project
+    std::vector<TextureManager::Handle> textures;
 };
@@ -1,56 +1,346 @@
 // Created by Modar Nasser on 13/03/2022.
 
 #include "LDtkProjectObjects.hpp"
+#include "GeometryCache.hpp"
+#include "Profiler.hpp"
 #include "TextureManager.hpp"
+#include "ThreadPool.hpp"
 
 #include "ldtk2glm.hpp"
 
-static glm::vec2 level_offset = {0, 0};
-static glm::vec2 level_pos = {0, 0};
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <type_traits>
+#include <utility>
 
-LDtkProjectObjects::World::World(const ldtk::World& world, const ldtk::FilePath& filepath) :
+constexpr auto entity_cell_size = 128.f;
+
+namespace {
+    // field values formatting, appended to the entity values buffer
+    void append(std::string& text, int value) {
+        char buffer[16];
+        const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        text.append(buffer, result.ptr);
+    }
+
+    void append(std::string& text, float value) {
+        char buffer[32];
+        const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+        text.append(buffer, result.ptr);
+    }
+
+    void append(std::string& text, bool value) {
+        text += value ? "true" : "false";
+    }
+
+    void append(std::string& text, const std::string& value) {
+        text += value;
+    }
+
+    void append(std::string& text, const ldtk::Color& color) {
+        constexpr const char* digits = "0123456789ABCDEF";
+        text += '#';
+        for (const auto component : {color.r, color.g, color.b, color.a}) {
+            text += digits[component >> 4];
+            text += digits[component & 0xF];
+        }
+    }
+
+    void append(std::string& text, const ldtk::IntPoint& point) {
+        text += '(';
+        append(text, point.x);
+        text += ", ";
+        append(text, point.y);
+        text += ')';
+    }
+
+    void append(std::string& text, const ldtk::EnumValue& value) {
+        text += value.name;
+    }
+
+    void append(std::string& text, const ldtk::EntityRef& ref) {
+        text += ref->getName();
+    }
+
+    template <typename T>
+    void append(std::string& text, const ldtk::Field<T>& field) {
+        if (field.is_null())
+            text += "null";
+        else
+            append(text, field.value());
+    }
+
+    // null when there is nothing to draw
+    std::unique_ptr<sogl::VertexArray> makeVertexArray(const LDtkProjectObjects::Quad* quads, std::size_t count) {
+        if (count == 0)
+            return nullptr;
+        auto vertex_array = std::make_unique<sogl::VertexArray>();
+        vertex_array->reserve(count * 4);
+        for (std::size_t i = 0; i < count; ++i)
+            vertex_array->pushQuad(quads[i]);
+        return vertex_array;
+    }
+
+    class FieldValuesWriter {
+    public:
+        explicit FieldValuesWriter(LDtkProjectObjects::FieldValues& values) : m_values(values)
+        {}
+
+        template <typename T>
+        void value(const ldtk::Field<T>& field, const std::string& prefix = {}) {
+            const auto offset = m_values.text.size();
+            m_values.text += prefix;
+            append(m_values.text, field);
+            const auto lines = 1 + std::count(m_values.text.begin() + static_cast<std::ptrdiff_t>(offset), m_values.text.end(), '\n');
+            m_values.text += '\0';
+            const ldtk::Entity* target = nullptr;
+            if constexpr (std::is_same_v<T, ldtk::EntityRef>) {
+                if (!field.is_null())
+                    target = field.value().operator->();
+            }
+            m_values.values.push_back({static_cast<std::uint32_t>(offset), static_cast<std::uint32_t>(lines), target});
+        }
+
+        template <typename T>
+        void values(const ldtk::ArrayField<T>& fields, const std::string& prefix = {}) {
+            for (const auto& field : fields)
+                value(field, prefix);
+        }
+
+    private:
+        LDtkProjectObjects::FieldValues& m_values;
+    };
+}
+
+LDtkProjectObjects::World::World(const ldtk::World& world, const std::string& filepath, ThreadPool& pool,
+                                 const std::function<void()>& on_level_built) :
 data(world) {
-    short_name = filepath.filename().substr(0, filepath.filename().find('.'));
-    level_offset = {0, 0};
-    for (const auto& level : world.allLevels()) {
-        auto& last_level = levels[level.depth].emplace_back(level, filepath);
+    const auto filename = std::filesystem::path(filepath).filename().string();
+    short_name = filename.substr(0, filename.find('.'));
+    const auto directory = directoryOf(filepath);
+
+    // linear layouts place levels one after the other, offsets are computed up front so that levels are independent
+    const auto& all_levels = world.allLevels();
+    std::vector<glm::vec2> offsets(all_levels.size());
+    glm::vec2 level_offset = {0, 0};
+    for (std::size_t i = 0; i < all_levels.size(); ++i) {
+        offsets[i] = level_offset;
         if (world.getLayout() == ldtk::WorldLayout::LinearHorizontal) {
-            level_offset.x += last_level.bounds.size.x + 10;
+            level_offset.x += static_cast<float>(all_levels[i].size.x) + 10;
         }
         else if (world.getLayout() == ldtk::WorldLayout::LinearVertical) {
-            level_offset.y += last_level.bounds.size.y + 10;
+            level_offset.y += static_cast<float>(all_levels[i].size.y) + 10;
+        }
+    }
+
+    std::vector<std::unique_ptr<Level>> built(all_levels.size());
+    pool.parallelFor(all_levels.size(), [&](std::size_t i) {
+        built[i] = std::make_unique<Level>(all_levels[i], directory, offsets[i]);
+        if (on_level_built)
+            on_level_built();
+    });
+    // moved in the original order, so that the result doesn't depend on the scheduling
+    for (auto& level : built)
+        levels[level->data.depth].push_back(std::move(*level));
+
+    // spatial indices are built once all levels are in place, so that pointers stay valid
+    for (const auto& [depth, depth_levels] : levels) {
+        auto cell_size = 0.f;
+        for (const auto& level : depth_levels)
+            cell_size += std::max(level.bounds.size.x, level.bounds.size.y);
+        cell_size /= static_cast<float>(depth_levels.size());
+
+        auto& level_grid = level_index.emplace(depth, SpatialGrid<const Level*>(cell_size)).first->second;
+        auto& entity_grid = entity_index.emplace(depth, SpatialGrid<EntityLocation>(entity_cell_size)).first->second;
+        for (const auto& level : depth_levels) {
+            level_grid.insert(&level, level.bounds);
+            // inserted in render order, so that picking returns the top-most entity
+            for (auto layer_it = level.layers.rbegin(); layer_it < level.layers.rend(); layer_it++) {
+                for (const auto& entity : layer_it->entities)
+                    entity_grid.insert({&level, &entity}, entity.bounds);
+            }
         }
     }
 }
 
-LDtkProjectObjects::Level::Level(const ldtk::Level& level, const ldtk::FilePath& filepath) :
+void LDtkProjectObjects::indexIids() {
+    m_iid_index.clear();
+    for (const auto& world : worlds) {
+        m_iid_index[world.data.iid.str()] = {&world};
+        for (const auto& [_, depth_levels] : world.levels)
+            for (const auto& level : depth_levels)
+                indexIids(world, level);
+    }
+}
+
+void LDtkProjectObjects::indexIids(const World& world, const Level& level) {
+    m_iid_index[level.data.iid.str()] = {&world, &level};
+    for (const auto& layer : level.layers) {
+        m_iid_index[layer.data.iid.str()] = {&world, &level, &layer};
+        for (const auto& entity : layer.entities)
+            m_iid_index[entity.data.iid.str()] = {&world, &level, &layer, &entity};
+    }
+}
+
+auto LDtkProjectObjects::findIid(const std::string& iid) const -> const IidLocation* {
+    const auto it = m_iid_index.find(iid);
+    return it != m_iid_index.end() ? &it->second : nullptr;
+}
+
+std::string LDtkProjectObjects::directoryOf(const std::string& filepath) {
+    auto directory = std::filesystem::path(filepath).parent_path().generic_string();
+    if (!directory.empty())
+        directory += '/';
+    return directory;
+}
+
+LDtkProjectObjects::Level::Level(const ldtk::Level& level, const std::string& directory, const glm::vec2& offset) :
 data(level) {
-    bounds.pos.x = level.position.x + level_offset.x;
-    bounds.pos.y = level.position.y + level_offset.y;
-    level_pos = bounds.pos;
+    bounds.pos.x = level.position.x + offset.x;
+    bounds.pos.y = level.position.y + offset.y;
     bounds.size.x = level.size.x;
     bounds.size.y = level.size.y;
     layers.reserve(level.allLayers().size());
     for (const auto& layer : level.allLayers()) {
-        layers.emplace_back(layer, filepath);
+        layers.emplace_back(layer, directory, bounds.pos);
+    }
+    indexEntities();
+    label_id = "##" + level.iid.str();
+}
+
+void LDtkProjectObjects::Level::indexEntities() {
+    entities.clear();
+    for (const auto& layer : layers)
+        for (const auto& entity : layer.entities)
+            entities.push_back(&entity);
+}
+
+bool LDtkProjectObjects::Level::hasGeometry(bool tiles, bool entities) const {
+    return std::all_of(layers.begin(), layers.end(), [&](const Layer& layer) {
+        return layer.hasGeometry(tiles, entities);
+    });
+}
+
+void LDtkProjectObjects::Level::buildGeometry(bool tiles, bool entities) const {
+    // a level missing from the cache is written then read, its layers use the mapped geometry
+    if (geometry_cache != nullptr && !m_geometry_cache_read) {
+        m_geometry_cache_read = true;
+        if (!geometry_cache->read(*this) && geometry_cache->write(*this))
+            geometry_cache->read(*this);
     }
+    for (const auto& layer : layers)
+        layer.buildGeometry(tiles, entities);
+}
+
+void LDtkProjectObjects::Level::uploadGeometry(bool tiles, bool entities) const {
+    for (const auto& layer : layers)
+        layer.uploadGeometry(tiles, entities);
+}
+
+void LDtkProjectObjects::Level::releaseGeometry() const {
+    for (const auto& layer : layers)
+        layer.releaseGeometry();
+}
+
+std::size_t LDtkProjectObjects::Level::getGeometrySize() const {
+    std::size_t size = 0;
+    for (const auto& layer : layers)
+        size += layer.getGeometrySize();
+    return size;
 }
 
-LDtkProjectObjects::Layer::Layer(const ldtk::Layer& layer, const ldtk::FilePath& filepath) :
-data(layer) {
+LDtkProjectObjects::Layer::Layer(const ldtk::Layer& layer, const std::string& directory, const glm::vec2& level_pos) :
+data(layer), m_level_pos(level_pos) {
+    bounds.pos = level_pos + glm::vec2(ldtk2glm(layer.getOffset()));
+    bounds.size = glm::vec2(ldtk2glm(layer.getGridSize()) * layer.getCellSize());
+
     if (!layer.allTiles().empty()) {
-        auto proj_dir = filepath.directory();
-        m_texture = &TextureManager::get(proj_dir + layer.getTileset().path);
+        texture_path = directory + layer.getTileset().path;
+    }
+
+    entities.reserve(layer.allEntities().size());
+    for (const auto& entity : layer.allEntities())
+        entities.emplace_back(entity, level_pos);
+}
+
+void LDtkProjectObjects::Layer::setCachedGeometry(const Quad* tiles, std::size_t tiles_count,
+                                                  const Quad* entities, std::size_t entities_count) const {
+    m_cached_tiles = tiles;
+    m_cached_tiles_count = tiles_count;
+    m_cached_entities = entities;
+    m_cached_entities_count = entities_count;
+}
+
+void LDtkProjectObjects::Layer::takeGeometry(Layer& previous) {
+    m_va_tiles = std::move(previous.m_va_tiles);
+    m_va_entities = std::move(previous.m_va_entities);
+    m_texture = previous.m_texture;
+    m_tiles_uploaded = std::exchange(previous.m_tiles_uploaded, false);
+    m_entities_uploaded = std::exchange(previous.m_entities_uploaded, false);
+    m_tiles_vertices = std::exchange(previous.m_tiles_vertices, 0);
+    m_entities_vertices = std::exchange(previous.m_entities_vertices, 0);
+}
+
+bool LDtkProjectObjects::Layer::hasGeometry(bool tiles, bool entities) const {
+    return (!tiles || m_tiles_uploaded) && (!entities || m_entities_uploaded);
+}
+
+void LDtkProjectObjects::Layer::buildGeometry(bool tiles, bool entities) const {
+    // cached parts and parts already uploaded don't need to be built
+    if (tiles && !m_tiles_uploaded && m_cached_tiles == nullptr) {
+        m_tiles_quads.clear();
+        buildTilesQuads(data, m_level_pos, m_tiles_quads);
+    }
+    if (entities && !m_entities_uploaded && m_cached_entities == nullptr) {
+        m_entities_quads.clear();
+        buildEntitiesQuads(data, m_level_pos, m_entities_quads);
+    }
+}
+
+void LDtkProjectObjects::Layer::uploadGeometry(bool tiles, bool entities) const {
+    if (tiles && !m_tiles_uploaded) {
+        if (!texture_path.empty())
+            m_texture = &TextureManager::get(texture_path);
+        const auto cached = m_cached_tiles != nullptr;
+        m_va_tiles = makeVertexArray(cached ? m_cached_tiles : m_tiles_quads.data(),
+                                     cached ? m_cached_tiles_count : m_tiles_quads.size());
+        m_tiles_vertices = (cached ? m_cached_tiles_count : m_tiles_quads.size()) * 4;
+        m_tiles_uploaded = true;
+        // the geometry now lives on the GPU
+        m_tiles_quads = {};
+    }
+    if (entities && !m_entities_uploaded) {
+        const auto cached = m_cached_entities != nullptr;
+        m_va_entities = makeVertexArray(cached ? m_cached_entities : m_entities_quads.data(),
+                                        cached ? m_cached_entities_count : m_entities_quads.size());
+        m_entities_vertices = (cached ? m_cached_entities_count : m_entities_quads.size()) * 4;
+        m_entities_uploaded = true;
+        m_entities_quads = {};
     }
+}
+
+void LDtkProjectObjects::Layer::releaseGeometry() const {
+    m_va_tiles.reset();
+    m_va_entities.reset();
+    m_tiles_uploaded = false;
+    m_entities_uploaded = false;
+    m_tiles_vertices = 0;
+    m_entities_vertices = 0;
+}
 
-    m_va_tiles.reserve(layer.allTiles().size() * 4);
+std::size_t LDtkProjectObjects::Layer::getGeometrySize() const {
+    return (m_tiles_vertices + m_entities_vertices) * sizeof(sogl::Vertex);
+}
 
+void LDtkProjectObjects::Layer::buildTilesQuads(const ldtk::Layer& layer, const glm::vec2& level_pos, std::vector<Quad>& quads) {
+    quads.reserve(quads.size() + layer.allTiles().size());
     for (const auto& tile : layer.allTiles()) {
         if (tile.getPosition().x < 0 || tile.getPosition().x > layer.getGridSize().x * layer.getCellSize()
             || tile.getPosition().y < 0 || tile.getPosition().y > layer.getGridSize().y * layer.getCellSize())
             continue;
         auto tile_verts = tile.getVertices();
-        std::array<sogl::Vertex, 4> quad {};
+        auto& quad = quads.emplace_back();
         for (int i = 0; i < 4; ++i) {
             quad[i].pos.x = level_pos.x + tile_verts[i].pos.x;
             quad[i].pos.y = level_pos.y + tile_verts[i].pos.y;
@@ -58,14 +348,12 @@ data(layer) {
             quad[i].tex.y = static_cast<float>(tile_verts[i].tex.y);
             quad[i].col = {1.f, 1.f, 1.f, layer.getOpacity()};
         }
-        m_va_tiles.pushQuad(quad);
     }
+}
 
-    entities.reserve(layer.allEntities().size());
-    m_va_entities.reserve(layer.allEntities().size() * 4);
-
+void LDtkProjectObjects::Layer::buildEntitiesQuads(const ldtk::Layer& layer, const glm::vec2& level_pos, std::vector<Quad>& quads) {
+    quads.reserve(quads.size() + layer.allEntities().size());
     for (const auto& entity : layer.allEntities()) {
-        entities.emplace_back(entity);
         auto size = glm::vec2(ldtk2glm(entity.getSize()));
         auto pos = glm::vec2(level_pos.x + entity.getPosition().x - size.x * entity.getPivot().x,
                              level_pos.y + entity.getPosition().y - size.y * entity.getPivot().y);
@@ -77,35 +365,127 @@ data(layer) {
         auto tr = sogl::Vertex{{pos.x + size.x, pos.y}, tex, color};
         auto br = sogl::Vertex{{pos.x + size.x, pos.y + size.y}, tex, color};
         auto bl = sogl::Vertex{{pos.x, pos.y + size.y}, tex, color};
-        m_va_entities.pushQuad({tl, tr, br, bl});
+        quads.push_back({tl, tr, br, bl});
     }
 }
 
 void LDtkProjectObjects::Layer::render(sogl::Shader& shader, bool render_entities) const {
-    if (m_texture != nullptr) {
-        shader.setUniform("texture_size", glm::vec2(m_texture->getSize()));
-        m_texture->bind();
-    } else {
-        shader.setUniform("texture_size", glm::vec2(0, 0));
+    if (m_va_tiles != nullptr) {
+        if (m_texture != nullptr) {
+            shader.setUniform("texture_size", glm::vec2(m_texture->getSize()));
+            m_texture->bind();
+            Profiler::countTextureBind();
+        } else {
+            shader.setUniform("texture_size", glm::vec2(0, 0));
+        }
+        m_va_tiles->bind();
+        m_va_tiles->render();
+        Profiler::countDraw(m_tiles_vertices);
     }
-    m_va_tiles.bind();
-    m_va_tiles.render();
 
     if (render_entities) {
-        m_va_entities.bind();
-        m_va_entities.render();
+        renderEntities(shader);
     }
 }
 
-LDtkProjectObjects::Entity::Entity(const ldtk::Entity& entity) :
+void LDtkProjectObjects::Layer::renderEntities(sogl::Shader& shader) const {
+    if (m_va_entities == nullptr)
+        return;
+    shader.setUniform("texture_size", glm::vec2(0, 0));
+    m_va_entities->bind();
+    m_va_entities->render();
+    Profiler::countDraw(m_entities_vertices);
+}
+
+LDtkProjectObjects::Entity::Entity(const ldtk::Entity& entity, const glm::vec2& level_pos) :
 data(entity) {
     fields.reserve(entity.allFields().size());
     for (const auto& field : entity.allFields()) {
-        fields.emplace_back(field);
+        fields.emplace_back(field, fields.size());
     }
-    bounds.pos = level_pos + glm::vec2(ldtk2glm(entity.getPosition()));
     bounds.size = ldtk2glm(entity.getSize());
+    bounds.pos = level_pos + glm::vec2(ldtk2glm(entity.getPosition())) - bounds.size * ldtk2glm(entity.getPivot());
+    label_id = "##" + entity.iid.str();
+}
+
+auto LDtkProjectObjects::Entity::getFieldValues() const -> const FieldValues& {
+    // fields are looked up by name once, then the values are read by index
+    if (m_field_values == nullptr) {
+        m_field_values = std::make_unique<FieldValues>();
+        formatFieldValues(*m_field_values);
+    }
+    return *m_field_values;
+}
+
+void LDtkProjectObjects::Entity::formatFieldValues(FieldValues& result) const {
+    result.text.clear();
+    result.values.clear();
+    result.fields.clear();
+    FieldValuesWriter writer(result);
+    result.fields.reserve(fields.size() + 1);
+    for (const auto& field : fields) {
+        const auto& def = field.data;
+        result.fields.push_back(static_cast<std::uint32_t>(result.values.size()));
+        switch (def.type) {
+            case ldtk::FieldType::Int:
+                writer.value(data.getField<ldtk::FieldType::Int>(def.name));
+                break;
+            case ldtk::FieldType::Float:
+                writer.value(data.getField<ldtk::FieldType::Float>(def.name));
+                break;
+            case ldtk::FieldType::Bool:
+                writer.value(data.getField<ldtk::FieldType::Bool>(def.name));
+                break;
+            case ldtk::FieldType::String:
+                writer.value(data.getField<ldtk::FieldType::String>(def.name));
+                break;
+            case ldtk::FieldType::Color:
+                writer.value(data.getField<ldtk::FieldType::Color>(def.name));
+                break;
+            case ldtk::FieldType::Point:
+                writer.value(data.getField<ldtk::FieldType::Point>(def.name));
+                break;
+            case ldtk::FieldType::Enum:
+                writer.value(data.getField<ldtk::FieldType::Enum>(def.name));
+                break;
+            case ldtk::FieldType::FilePath:
+                writer.value(data.getField<ldtk::FieldType::FilePath>(def.name));
+                break;
+            case ldtk::FieldType::EntityRef:
+                writer.value(data.getField<ldtk::FieldType::EntityRef>(def.name), data.getName() + "->");
+                break;
+            case ldtk::FieldType::ArrayInt:
+                writer.values(data.getField<ldtk::FieldType::ArrayInt>(def.name));
+                break;
+            case ldtk::FieldType::ArrayFloat:
+                writer.values(data.getField<ldtk::FieldType::ArrayFloat>(def.name));
+                break;
+            case ldtk::FieldType::ArrayBool:
+                writer.values(data.getField<ldtk::FieldType::ArrayBool>(def.name));
+                break;
+            case ldtk::FieldType::ArrayString:
+                writer.values(data.getField<ldtk::FieldType::ArrayString>(def.name));
+                break;
+            case ldtk::FieldType::ArrayColor:
+                writer.values(data.getField<ldtk::FieldType::ArrayColor>(def.name));
+                break;
+            case ldtk::FieldType::ArrayPoint:
+                writer.values(data.getField<ldtk::FieldType::ArrayPoint>(def.name));
+                break;
+            case ldtk::FieldType::ArrayEnum:
+                writer.values(data.getField<ldtk::FieldType::ArrayEnum>(def.name));
+                break;
+            case ldtk::FieldType::ArrayFilePath:
+                writer.values(data.getField<ldtk::FieldType::ArrayFilePath>(def.name));
+                break;
+            case ldtk::FieldType::ArrayEntityRef:
+                writer.values(data.getField<ldtk::FieldType::ArrayEntityRef>(def.name), data.getName() + "->");
+                break;
+        }
+    }
+    result.fields.push_back(static_cast<std::uint32_t>(result.values.size()));
 }
 
-LDtkProjectObjects::Field::Field(const ldtk::FieldDef& field) : data(field)
+LDtkProjectObjects::Field::Field(const ldtk::FieldDef& field, std::size_t index) : data(field), index(index),
+label_id("##" + std::to_string(static_cast<int>(field.type)) + " " + field.name)
 {}
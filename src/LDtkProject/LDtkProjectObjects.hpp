@@ -2,6 +2,9 @@
 
 #pragma once
 
+#include "Rect.hpp"
+#include "SpatialGrid.hpp"
+
 #include <sogl/Shader.hpp>
 #include <sogl/Texture.hpp>
 #include <sogl/VertexArray.hpp>
@@ -10,53 +13,173 @@
 #include <LDtkLoader/Level.hpp>
 #include <LDtkLoader/World.hpp>
 
+#include <array>
+#include <cstdint>
+#include <functional>
 #include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
-struct Rect {
-    glm::vec2 pos;
-    glm::vec2 size;
-};
+class GeometryCache;
+class ThreadPool;
 
 class LDtkProjectObjects {
 public:
+    // label_id members are the hidden ImGui ids of the lists rows, built once with the objects
+
     struct Field {
-        explicit Field(const ldtk::FieldDef& field);
+        explicit Field(const ldtk::FieldDef& field, std::size_t index);
         const ldtk::FieldDef& data;
+        // index of the field in its entity fields and field values
+        std::size_t index;
+        std::string label_id;
+    };
+
+    // values of all the fields of an entity formatted as text, null terminated in a single buffer
+    struct FieldValues {
+        struct Value {
+            std::uint32_t offset;
+            std::uint32_t lines;
+            // entity referenced by an EntityRef value, null otherwise
+            const ldtk::Entity* target;
+        };
+        // values of a field are in [begin(field), end(field))
+        std::size_t begin(std::size_t field) const { return fields[field]; }
+        std::size_t end(std::size_t field) const { return fields[field + 1]; }
+        const char* getText(std::size_t value) const { return text.data() + values[value].offset; }
+
+        std::string text;
+        std::vector<Value> values;
+        // index of the first value of each field, followed by the values count
+        std::vector<std::uint32_t> fields;
     };
 
     struct Entity {
-        explicit Entity(const ldtk::Entity& Entity);
+        explicit Entity(const ldtk::Entity& Entity, const glm::vec2& level_pos);
+        // formatted on first call, must be called from the GL thread
+        const FieldValues& getFieldValues() const;
+        // formats the values without caching them, can be called from any thread
+        void formatFieldValues(FieldValues& values) const;
         const ldtk::Entity& data;
         std::vector<Field> fields;
         Rect bounds;
+        std::string label_id;
+    private:
+        mutable std::unique_ptr<FieldValues> m_field_values;
     };
 
+    using Quad = std::array<sogl::Vertex, 4>;
+
+    // Objects are built on the CPU only, so that it can be done outside of the GL thread.
+    // Their geometry is a cache derived from the data: the parts that are drawn (tiles, entities) are built when
+    // the level becomes visible (buildGeometry() on any thread, then uploadGeometry() with the same parts on the
+    // GL thread) and released when evicted.
     struct Layer {
-        explicit Layer(const ldtk::Layer& layer, const ldtk::FilePath& filepath);
+        explicit Layer(const ldtk::Layer& layer, const std::string& directory, const glm::vec2& level_pos);
+        bool hasGeometry(bool tiles, bool entities) const;
+        void buildGeometry(bool tiles, bool entities) const;
+        void uploadGeometry(bool tiles, bool entities) const;
+        void releaseGeometry() const;
+        std::size_t getGeometrySize() const;
+        // geometry built ahead of time, used instead of building it, must outlive the layer rendering
+        void setCachedGeometry(const Quad* tiles, std::size_t tiles_count, const Quad* entities, std::size_t entities_count) const;
+        // takes the uploaded geometry of the same layer in a previous version of the project
+        void takeGeometry(Layer& previous);
+
         void render(sogl::Shader& shader, bool render_entities=false) const;
+        void renderEntities(sogl::Shader& shader) const;
+
+        // geometry in world coordinates, tiles texture coordinates being in pixels
+        static void buildTilesQuads(const ldtk::Layer& layer, const glm::vec2& level_pos, std::vector<Quad>& quads);
+        static void buildEntitiesQuads(const ldtk::Layer& layer, const glm::vec2& level_pos, std::vector<Quad>& quads);
+
         const ldtk::Layer& data;
         std::vector<Entity> entities;
+        Rect bounds;
+        // path of the tileset texture, empty if the layer has no tiles
+        std::string texture_path;
+        // hash of the layer JSON, 0 when unknown
+        std::uint64_t content_hash = 0;
     private:
-        sogl::VertexArray m_va_tiles;
-        sogl::VertexArray m_va_entities;
-        sogl::Texture* m_texture = nullptr;
+        glm::vec2 m_level_pos;
+        mutable std::vector<Quad> m_tiles_quads;
+        mutable std::vector<Quad> m_entities_quads;
+        mutable const Quad* m_cached_tiles = nullptr;
+        mutable std::size_t m_cached_tiles_count = 0;
+        mutable const Quad* m_cached_entities = nullptr;
+        mutable std::size_t m_cached_entities_count = 0;
+        // null when the part is empty or not uploaded
+        mutable std::unique_ptr<sogl::VertexArray> m_va_tiles;
+        mutable std::unique_ptr<sogl::VertexArray> m_va_entities;
+        mutable sogl::Texture* m_texture = nullptr;
+        mutable bool m_tiles_uploaded = false;
+        mutable bool m_entities_uploaded = false;
+        mutable std::size_t m_tiles_vertices = 0;
+        mutable std::size_t m_entities_vertices = 0;
     };
 
     struct Level {
-        explicit Level(const ldtk::Level& level, const ldtk::FilePath& filepath);
+        explicit Level(const ldtk::Level& level, const std::string& directory, const glm::vec2& offset);
+        bool hasGeometry(bool tiles, bool entities) const;
+        void buildGeometry(bool tiles, bool entities) const;
+        void uploadGeometry(bool tiles, bool entities) const;
+        void releaseGeometry() const;
+        std::size_t getGeometrySize() const;
+        // lists the entities of all the layers, must be called again when the layers are replaced
+        void indexEntities();
         const ldtk::Level& data;
         std::vector<Layer> layers;
+        // entities of the layers, in the layers order
+        std::vector<const Entity*> entities;
         Rect bounds;
+        // hash of the level JSON, 0 when unknown
+        std::uint64_t content_hash = 0;
+        std::string label_id;
+        // persistent cache of the layers geometry, read or written the first time the level is built, can be null
+        GeometryCache* geometry_cache = nullptr;
+    private:
+        mutable bool m_geometry_cache_read = false;
+    };
+
+    struct EntityLocation {
+        const Level* level;
+        const Entity* entity;
     };
 
     struct World {
-        explicit World(const ldtk::World& world, const ldtk::FilePath& filepath);
+        // levels are built in parallel on the pool, on_level_built may be called from any of its threads
+        explicit World(const ldtk::World& world, const std::string& filepath, ThreadPool& pool,
+                       const std::function<void()>& on_level_built = {});
         const ldtk::World& data;
         std::map<int, std::vector<Level>> levels;
+        std::map<int, SpatialGrid<const Level*>> level_index;
+        std::map<int, SpatialGrid<EntityLocation>> entity_index;
         std::string short_name;
     };
 
+    // what an iid designates, the objects below it are null
+    struct IidLocation {
+        const World* world = nullptr;
+        const Level* level = nullptr;
+        const Layer* layer = nullptr;
+        const Entity* entity = nullptr;
+    };
+
+    // directory of a project file, with its trailing separator, tilesets paths are relative to it
+    static std::string directoryOf(const std::string& filepath);
+
+    // indexes the iids of all the worlds content, once the worlds are built
+    void indexIids();
+    // indexes the iids of a level content, when its layers are replaced
+    void indexIids(const World& world, const Level& level);
+    // null if no object has this iid
+    auto findIid(const std::string& iid) const -> const IidLocation*;
+
     std::string name;
     std::vector<World> worlds;
+
+private:
+    std::unordered_map<std::string, IidLocation> m_iid_index;
 };
@@ -0,0 +1,140 @@
+#include "LevelCache.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+LevelCache::Resource::Resource(LevelCache& cache) : m_cache(cache) {
+    m_cache.m_resources.push_back(this);
+}
+
+LevelCache::Resource::~Resource() {
+    m_cache.remove(*this);
+}
+
+LevelCache::LevelCache(std::size_t budget) : m_budget(budget)
+{}
+
+void LevelCache::require(const std::vector<const Level*>& levels, ThreadPool& pool, bool tiles, bool entities) {
+    m_missing.clear();
+    for (const auto* level : levels) {
+        auto it = m_entries.find(level);
+        if (it != m_entries.end()) {
+            it->second->frame = m_frame;
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+        } else {
+            // measured on trim, once the renderers built their data
+            m_lru.push_front({level, 0, m_frame});
+            m_entries[level] = m_lru.begin();
+        }
+        if (!level->hasGeometry(tiles, entities))
+            m_missing.push_back(level);
+    }
+    if (m_missing.empty())
+        return;
+
+    pool.parallelFor(m_missing.size(), [this, tiles, entities](std::size_t i) {
+        m_missing[i]->buildGeometry(tiles, entities);
+    });
+    for (const auto* level : m_missing)
+        level->uploadGeometry(tiles, entities);
+}
+
+void LevelCache::trim() {
+    // levels required this frame are the first ones
+    for (auto& entry : m_lru) {
+        if (entry.frame != m_frame)
+            break;
+        m_used -= entry.size;
+        entry.size = measure(*entry.level);
+        m_used += entry.size;
+    }
+    while (m_used + m_pinned > m_budget && !m_lru.empty() && m_lru.back().frame != m_frame)
+        evict(std::prev(m_lru.end()));
+    m_frame++;
+}
+
+void LevelCache::invalidate(const Level& level) {
+    auto it = m_entries.find(&level);
+    if (it != m_entries.end())
+        evict(it->second);
+    else
+        release(level);
+}
+
+void LevelCache::transfer(const Level& from, const Level& to) {
+    auto node = m_entries.extract(&from);
+    if (node.empty())
+        return;
+    node.key() = &to;
+    auto& entry = *node.mapped();
+    entry.level = &to;
+    m_used -= entry.size;
+    entry.size = measure(to);
+    m_used += entry.size;
+    m_entries.insert(std::move(node));
+}
+
+void LevelCache::forget(const LDtkProjectObjects& objects) {
+    for (const auto& world : objects.worlds) {
+        for (const auto& [_, levels] : world.levels) {
+            for (const auto& level : levels)
+                invalidate(level);
+        }
+    }
+}
+
+void LevelCache::clear() {
+    while (!m_lru.empty())
+        evict(m_lru.begin());
+}
+
+void LevelCache::setBudget(std::size_t budget) {
+    m_budget = budget;
+}
+
+void LevelCache::setPinnedMemory(std::size_t memory) {
+    m_pinned = memory;
+}
+
+std::size_t LevelCache::getBudget() const {
+    return m_budget;
+}
+
+std::size_t LevelCache::getUsedMemory() const {
+    return m_used + m_pinned;
+}
+
+std::size_t LevelCache::getResidentCount() const {
+    return m_lru.size();
+}
+
+std::size_t LevelCache::measure(const Level& level) const {
+    auto size = level.getGeometrySize();
+    for (const auto* resource : m_resources)
+        size += resource->getMemory(level);
+    return size;
+}
+
+void LevelCache::release(const Level& level) {
+    level.releaseGeometry();
+    for (auto* resource : m_resources)
+        resource->release(level);
+}
+
+void LevelCache::evict(std::list<Entry>::iterator it) {
+    release(*it->level);
+    m_used -= it->size;
+    m_entries.erase(it->level);
+    m_lru.erase(it);
+}
+
+void LevelCache::remove(Resource& resource) {
+    // the data of the resource was released with it, the levels are measured without it
+    m_resources.erase(std::remove(m_resources.begin(), m_resources.end(), &resource), m_resources.end());
+    m_used = 0;
+    for (auto& entry : m_lru) {
+        entry.size = measure(*entry.level);
+        m_used += entry.size;
+    }
+}
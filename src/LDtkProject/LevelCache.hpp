@@ -0,0 +1,80 @@
+#pragma once
+
+#include "LDtkProjectObjects.hpp"
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+
+// Keeps the GPU data of the most recently visible levels, within a memory budget: the parts of their layers
+// geometry that are drawn, and the data the renderers build for them (resources).
+// Levels are made resident when they are required, and the least recently used ones are evicted on trim().
+class LevelCache {
+public:
+    using Level = LDtkProjectObjects::Level;
+
+    // GPU data a renderer builds for the levels it draws, counted in the budget and released with the levels.
+    // Resources are registered with the cache for their whole lifetime.
+    class Resource {
+    public:
+        explicit Resource(LevelCache& cache);
+        virtual ~Resource();
+        Resource(const Resource&) = delete;
+        Resource& operator=(const Resource&) = delete;
+
+        virtual std::size_t getMemory(const Level& level) const = 0;
+        virtual void release(const Level& level) = 0;
+    private:
+        LevelCache& m_cache;
+    };
+
+    explicit LevelCache(std::size_t budget);
+
+    // makes the levels resident, the missing parts of their geometry are built on the pool and uploaded on the
+    // calling (GL) thread. Resources build their data themselves when the levels are drawn.
+    void require(const std::vector<const Level*>& levels, ThreadPool& pool, bool tiles, bool entities);
+    // measures the levels required this frame, then evicts least recently used levels until the budget is met,
+    // levels required this frame are kept
+    void trim();
+    // releases a level whose layers changed, it is rebuilt the next time it is required
+    void invalidate(const Level& level);
+    // makes the level of a reloaded project resident in place of the previous version of the level,
+    // whose GPU data was moved to the new one
+    void transfer(const Level& from, const Level& to);
+    // releases all the levels of a project, must be called before it is destroyed
+    void forget(const LDtkProjectObjects& objects);
+    // releases all the levels, when the data to draw them changes
+    void clear();
+
+    void setBudget(std::size_t budget);
+    // memory of the levels data that can't be evicted (streamed levels definitions), counted in the budget
+    void setPinnedMemory(std::size_t memory);
+    std::size_t getBudget() const;
+    // pinned memory included
+    std::size_t getUsedMemory() const;
+    std::size_t getResidentCount() const;
+
+private:
+    struct Entry {
+        const Level* level;
+        std::size_t size;
+        unsigned frame;
+    };
+    std::size_t measure(const Level& level) const;
+    void release(const Level& level);
+    void evict(std::list<Entry>::iterator it);
+    void remove(Resource& resource);
+
+    std::size_t m_budget;
+    std::size_t m_used = 0;
+    std::size_t m_pinned = 0;
+    unsigned m_frame = 0;
+    // most recently used first
+    std::list<Entry> m_lru;
+    std::unordered_map<const Level*, std::list<Entry>::iterator> m_entries;
+    std::vector<Resource*> m_resources;
+    std::vector<const Level*> m_missing;
+};
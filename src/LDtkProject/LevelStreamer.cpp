@@ -0,0 +1,195 @@
+#include "LevelStreamer.hpp"
+#include "JsonScanner.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+LevelStreamer::LevelStreamer(std::string_view header, std::string directory, LDtkProjectObjects& objects,
+                             const std::vector<std::string>& levels_paths) :
+m_objects(objects), m_state(std::make_shared<State>()) {
+    m_state->directory = std::move(directory);
+    const auto levels = JsonScanner(header).member("levels");
+    if (levels.found()) {
+        m_state->header_prefix.append(header.substr(0, levels.begin)).append("[");
+        m_state->header_suffix.append("]").append(header.substr(levels.end));
+    }
+
+    for (auto& world : objects.worlds) {
+        const auto& all_levels = world.data.allLevels();
+        for (auto& [_, depth_levels] : world.levels) {
+            for (auto& level : depth_levels) {
+                const auto index = static_cast<std::size_t>(&level.data - all_levels.data());
+                if (index >= levels_paths.size() || levels_paths[index].empty())
+                    continue;
+                auto& entry = m_entries[&level];
+                entry.level = &level;
+                entry.world = &world;
+                entry.path = m_state->directory + levels_paths[index];
+            }
+        }
+    }
+}
+
+LevelStreamer::~LevelStreamer() {
+    m_state->cancelled = true;
+}
+
+void LevelStreamer::request(const Level& level) {
+    auto it = m_entries.find(&level);
+    if (it == m_entries.end() || it->second.requested || m_state->header_prefix.empty())
+        return;
+    auto& entry = it->second;
+    if (Clock::now() < entry.retry_time)
+        return;
+    entry.requested = true;
+    m_queued.push_back(&entry);
+    m_pending++;
+}
+
+auto LevelStreamer::poll() -> const std::vector<const Level*>& {
+    m_updated.clear();
+
+    std::vector<Loaded> ready;
+    {
+        std::lock_guard lock(m_state->mutex);
+        ready.swap(m_state->ready);
+    }
+    for (auto& loaded : ready) {
+        for (auto* entry : loaded.failed) {
+            // requested again later
+            entry->requested = false;
+            entry->retry_time = Clock::now() + retry_delay;
+            m_pending--;
+        }
+        for (auto& [entry, layers] : loaded.levels) {
+            auto& level = *entry->level;
+            level.layers = std::move(layers);
+            level.indexEntities();
+            m_objects.indexIids(*entry->world, level);
+            // inserted in render order, so that picking returns the top-most entity
+            auto& entity_grid = entry->world->entity_index.at(level.data.depth);
+            for (auto layer_it = level.layers.rbegin(); layer_it < level.layers.rend(); layer_it++) {
+                for (const auto& entity : layer_it->entities)
+                    entity_grid.insert({&level, &entity}, entity.bounds);
+            }
+            m_updated.push_back(&level);
+            m_pending--;
+            m_loaded++;
+        }
+        if (loaded.project != nullptr)
+            m_projects.push_back(std::move(loaded.project));
+    }
+
+    m_tasks.erase(std::remove_if(m_tasks.begin(), m_tasks.end(), [](const std::future<void>& task) {
+        return task.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }), m_tasks.end());
+    submit();
+
+    return m_updated;
+}
+
+std::size_t LevelStreamer::getLevelsCount() const {
+    return m_entries.size();
+}
+
+std::size_t LevelStreamer::getLoadedCount() const {
+    return m_loaded;
+}
+
+std::size_t LevelStreamer::getPendingCount() const {
+    return m_pending;
+}
+
+std::size_t LevelStreamer::getProjectsCount() const {
+    return m_projects.size();
+}
+
+std::size_t LevelStreamer::getHeaderSize() const {
+    return m_state->header_prefix.size() + m_state->header_suffix.size();
+}
+
+void LevelStreamer::submit() {
+    if (m_queued.empty())
+        return;
+    // one batch per thread, each batch parses the definitions once
+    auto& pool = ThreadPool::global();
+    const auto batches = std::min<std::size_t>(std::max(1u, pool.getThreadsCount()), m_queued.size());
+    const auto batch_size = (m_queued.size() + batches - 1) / batches;
+    for (std::size_t begin = 0; begin < m_queued.size(); begin += batch_size) {
+        std::vector<Job> jobs;
+        for (auto i = begin; i < std::min(begin + batch_size, m_queued.size()); ++i)
+            jobs.push_back({m_queued[i], m_queued[i]->path, m_queued[i]->level->bounds.pos});
+        m_tasks.push_back(pool.submit([state = m_state, jobs = std::move(jobs)] {
+            load(*state, jobs);
+        }));
+    }
+    m_queued.clear();
+}
+
+void LevelStreamer::load(State& state, const std::vector<Job>& jobs) {
+    if (state.cancelled)
+        return;
+    Loaded loaded;
+    std::vector<const Job*> read;
+    auto failed = [&] {
+        for (const auto* job : read)
+            loaded.failed.push_back(job->entry);
+        std::lock_guard lock(state.mutex);
+        state.ready.push_back({nullptr, {}, std::move(loaded.failed)});
+    };
+
+    std::vector<std::uint8_t> bytes(state.header_prefix.begin(), state.header_prefix.end());
+    for (const auto& job : jobs) {
+        std::ifstream file(job.path, std::ios::binary);
+        if (!file) {
+            std::cerr << "Failed to open level " << job.path << std::endl;
+            loaded.failed.push_back(job.entry);
+            continue;
+        }
+        if (!read.empty())
+            bytes.push_back(',');
+        bytes.insert(bytes.end(), std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        read.push_back(&job);
+    }
+    bytes.insert(bytes.end(), state.header_suffix.begin(), state.header_suffix.end());
+
+    auto project = std::make_unique<ldtk::Project>();
+    try {
+        if (!read.empty())
+            project->loadFromMemory(bytes);
+    } catch (std::exception& ex) {
+        if (read.size() > 1) {
+            // a single broken file doesn't fail the levels loaded with it
+            bytes = {};
+            for (const auto* job : read)
+                load(state, {*job});
+            read.clear();
+            return failed();
+        }
+        std::cerr << "Failed to load level " << read.front()->path << ": " << ex.what() << std::endl;
+        return failed();
+    }
+    bytes = {};
+    const auto& worlds = project->allWorlds();
+    if (!read.empty() && (worlds.empty() || worlds.front().allLevels().size() != read.size()))
+        return failed();
+    if (state.cancelled)
+        return;
+
+    for (std::size_t i = 0; i < read.size(); ++i) {
+        const auto& level = worlds.front().allLevels()[i];
+        auto& layers = loaded.levels.emplace_back(LoadedLevel{read[i]->entry, {}}).layers;
+        layers.reserve(level.allLayers().size());
+        for (const auto& layer : level.allLayers())
+            layers.emplace_back(layer, state.directory, read[i]->level_pos);
+    }
+    if (!read.empty())
+        loaded.project = std::move(project);
+
+    std::lock_guard lock(state.mutex);
+    state.ready.push_back(std::move(loaded));
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "LDtkProjectObjects.hpp"
+
+#include <LDtkLoader/Project.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Loads the levels of a project saved with external levels (.ldtkl files) in the background, when requested.
+// The levels requested together are parsed as a project of their own, made of the project header and of these
+// levels: LDtkLoader can't parse a level against the definitions of an already loaded project, so each batch
+// holds a copy of the definitions. The header is stripped of its levels and of the definitions members the
+// loader doesn't read to keep these copies small, and the batches are kept as large as the pool allows.
+class LevelStreamer {
+public:
+    using Level = LDtkProjectObjects::Level;
+
+    // header is the project file without external levels, levels_paths are the level files relative to directory,
+    // in the order of the project levels
+    LevelStreamer(std::string_view header, std::string directory, LDtkProjectObjects& objects,
+                  const std::vector<std::string>& levels_paths);
+    // cancels the pending loads, the loads already running finish in the background and are discarded
+    ~LevelStreamer();
+    LevelStreamer(const LevelStreamer&) = delete;
+    LevelStreamer& operator=(const LevelStreamer&) = delete;
+
+    // queues the level to be loaded, unless it was already requested. The queued levels are loaded together on
+    // the global thread pool by the next poll(). Levels that failed to load are loaded again when requested after
+    // a delay
+    void request(const Level& level);
+    // moves the loaded layers into their level and starts loading the queued levels, must be called from the
+    // thread using the objects. Returns the levels updated by this call
+    auto poll() -> const std::vector<const Level*>&;
+
+    std::size_t getLevelsCount() const;
+    std::size_t getLoadedCount() const;
+    // levels requested and not loaded yet
+    std::size_t getPendingCount() const;
+    // projects kept for the loaded levels, each one holding a copy of the definitions
+    std::size_t getProjectsCount() const;
+    // size of the header JSON parsed with each project, an estimate of the definitions copies size
+    std::size_t getHeaderSize() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr auto retry_delay = std::chrono::seconds(1);
+
+    struct Entry {
+        Level* level = nullptr;
+        LDtkProjectObjects::World* world = nullptr;
+        std::string path;
+        bool requested = false;
+        Clock::time_point retry_time;
+    };
+    struct Job {
+        Entry* entry;
+        std::string path;
+        glm::vec2 level_pos;
+    };
+    struct LoadedLevel {
+        Entry* entry;
+        std::vector<LDtkProjectObjects::Layer> layers;
+    };
+    // result of a load, the levels loaded together share the project
+    struct Loaded {
+        std::unique_ptr<ldtk::Project> project;
+        std::vector<LoadedLevel> levels;
+        std::vector<Entry*> failed;
+    };
+    // shared with the loads, which may outlive the streamer
+    struct State {
+        // project header around the levels array
+        std::string header_prefix;
+        std::string header_suffix;
+        std::string directory;
+        std::atomic<bool> cancelled = false;
+        std::mutex mutex;
+        std::vector<Loaded> ready;
+    };
+    // parses the levels of the jobs in a single project, or one by one if it fails
+    static void load(State& state, const std::vector<Job>& jobs);
+    void submit();
+
+    LDtkProjectObjects& m_objects;
+    std::shared_ptr<State> m_state;
+
+    std::unordered_map<const Level*, Entry> m_entries;
+    std::vector<Entry*> m_queued;
+    std::vector<std::future<void>> m_tasks;
+    std::size_t m_pending = 0;
+    std::size_t m_loaded = 0;
+
+    std::vector<std::unique_ptr<ldtk::Project>> m_projects;
+    std::vector<const Level*> m_updated;
+};
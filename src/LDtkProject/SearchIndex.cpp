@@ -0,0 +1,166 @@
+#include "SearchIndex.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+    bool isWordCharacter(char c) {
+        // bytes of multibyte UTF-8 characters are kept in the words
+        const auto byte = static_cast<unsigned char>(c);
+        return byte >= 0x80 || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    char lower(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    // calls fn with each lower case word of the text, word is reused between the calls
+    template <typename Fn>
+    void forEachWord(std::string_view text, std::string& word, const Fn& fn) {
+        for (std::size_t i = 0; i < text.size();) {
+            if (!isWordCharacter(text[i])) {
+                ++i;
+                continue;
+            }
+            word.clear();
+            for (; i < text.size() && isWordCharacter(text[i]); ++i)
+                word += lower(text[i]);
+            fn(word);
+        }
+    }
+}
+
+SearchIndex::SearchIndex(const LDtkProjectObjects& objects) {
+    Postings postings;
+    for (const auto& world : objects.worlds) {
+        for (const auto& [_, depth_levels] : world.levels) {
+            for (const auto& level : depth_levels) {
+                m_documents.push_back({&world, &level, nullptr});
+                addText(postings, level.data.name);
+                addEntities(postings, world, level);
+            }
+        }
+    }
+    merge(postings);
+}
+
+void SearchIndex::add(const std::vector<const LDtkProjectObjects::Level*>& levels) {
+    Postings postings;
+    for (const auto* level : levels) {
+        // the level itself was indexed with the project
+        const auto it = std::find_if(m_documents.begin(), m_documents.end(), [&](const Document& document) {
+            return document.level == level && document.entity == nullptr;
+        });
+        if (it != m_documents.end())
+            addEntities(postings, *it->world, *level);
+    }
+    merge(postings);
+}
+
+void SearchIndex::addText(Postings& postings, std::string_view text) {
+    const auto document = static_cast<std::uint32_t>(m_documents.size() - 1);
+    forEachWord(text, m_word, [&](const std::string& w) {
+        // documents are added in order, a word seen twice in a document is the last one of its postings
+        auto& documents = postings[w];
+        if (documents.empty() || documents.back() != document)
+            documents.push_back(document);
+    });
+}
+
+void SearchIndex::addEntities(Postings& postings, const LDtkProjectObjects::World& world,
+                              const LDtkProjectObjects::Level& level) {
+    for (const auto* entity : level.entities) {
+        m_documents.push_back({&world, &level, entity});
+        addText(postings, entity->data.getName());
+        addText(postings, entity->data.iid.str());
+        entity->formatFieldValues(m_values);
+        for (std::size_t v = 0; v < m_values.values.size(); ++v)
+            addText(postings, m_values.getText(v));
+    }
+}
+
+void SearchIndex::merge(Postings& postings) {
+    std::vector<std::pair<std::string, std::vector<std::uint32_t>>> sorted(std::make_move_iterator(postings.begin()),
+                                                                          std::make_move_iterator(postings.end()));
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    // the added documents come after the indexed ones, their postings are appended to the ones of the same word
+    std::vector<std::string> words;
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::uint32_t> documents;
+    words.reserve(m_words.size() + sorted.size());
+    offsets.reserve(m_words.size() + sorted.size() + 1);
+    documents.reserve(m_postings.size());
+    std::size_t i = 0;
+    auto added = sorted.begin();
+    while (i < m_words.size() || added != sorted.end()) {
+        const auto indexed = i < m_words.size() && (added == sorted.end() || m_words[i] <= added->first);
+        const auto matched = indexed && added != sorted.end() && m_words[i] == added->first;
+        offsets.push_back(static_cast<std::uint32_t>(documents.size()));
+        if (indexed) {
+            words.push_back(std::move(m_words[i]));
+            documents.insert(documents.end(), m_postings.begin() + m_offsets[i], m_postings.begin() + m_offsets[i + 1]);
+            i++;
+        } else {
+            words.push_back(std::move(added->first));
+        }
+        if (!indexed || matched) {
+            documents.insert(documents.end(), added->second.begin(), added->second.end());
+            added++;
+        }
+    }
+    offsets.push_back(static_cast<std::uint32_t>(documents.size()));
+
+    m_words = std::move(words);
+    m_offsets = std::move(offsets);
+    m_postings = std::move(documents);
+    m_marks.resize(m_documents.size());
+}
+
+std::size_t SearchIndex::query(std::string_view text, std::vector<Document>& results, std::size_t max_results) const {
+    results.clear();
+    std::fill(m_marks.begin(), m_marks.end(), 0);
+
+    // a document is kept by a query word if it was kept by all the previous ones
+    std::uint8_t words = 0;
+    std::string word;
+    forEachWord(text, word, [&](const std::string& w) {
+        if (words == std::numeric_limits<std::uint8_t>::max())
+            return;
+        const auto first = std::lower_bound(m_words.begin(), m_words.end(), w);
+        for (auto it = first; it != m_words.end() && it->compare(0, w.size(), w) == 0; ++it) {
+            const auto index = static_cast<std::size_t>(it - m_words.begin());
+            for (auto p = m_offsets[index]; p < m_offsets[index + 1]; ++p) {
+                auto& mark = m_marks[m_postings[p]];
+                if (mark == words)
+                    mark = static_cast<std::uint8_t>(words + 1);
+            }
+        }
+        words++;
+    });
+    if (words == 0)
+        return 0;
+
+    std::size_t matches = 0;
+    for (std::size_t i = 0; i < m_documents.size(); ++i) {
+        if (m_marks[i] != words)
+            continue;
+        if (results.size() < max_results)
+            results.push_back(m_documents[i]);
+        matches++;
+    }
+    return matches;
+}
+
+std::size_t SearchIndex::getDocumentsCount() const {
+    return m_documents.size();
+}
+
+std::size_t SearchIndex::getWordsCount() const {
+    return m_words.size();
+}
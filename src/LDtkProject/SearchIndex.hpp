@@ -0,0 +1,58 @@
+#pragma once
+
+#include "LDtkProjectObjects.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Inverted index of the words of a project: levels names, entities names, iids and field values.
+// Words are split on the characters that are not letters nor digits, and compared without case.
+class SearchIndex {
+public:
+    // a level, or an entity of a level
+    struct Document {
+        const LDtkProjectObjects::World* world;
+        const LDtkProjectObjects::Level* level;
+        const LDtkProjectObjects::Entity* entity;
+    };
+
+    // indexes the levels present in the objects, the entities of streamed levels are added once they are loaded
+    explicit SearchIndex(const LDtkProjectObjects& objects);
+    SearchIndex(const SearchIndex&) = delete;
+    SearchIndex& operator=(const SearchIndex&) = delete;
+
+    // indexes the entities of levels loaded after the index was built, they are found after the other documents
+    void add(const std::vector<const LDtkProjectObjects::Level*>& levels);
+
+    // documents having a word starting with each word of the text, in the project order,
+    // results is filled with the max_results first ones and the count of all the matches is returned.
+    // Must not be called from several threads at once.
+    std::size_t query(std::string_view text, std::vector<Document>& results, std::size_t max_results) const;
+
+    std::size_t getDocumentsCount() const;
+    std::size_t getWordsCount() const;
+
+private:
+    // documents of each word, in increasing order
+    using Postings = std::unordered_map<std::string, std::vector<std::uint32_t>>;
+    // adds the words of the text to the last document
+    void addText(Postings& postings, std::string_view text);
+    void addEntities(Postings& postings, const LDtkProjectObjects::World& world, const LDtkProjectObjects::Level& level);
+    // adds the postings of new documents to the sorted words
+    void merge(Postings& postings);
+
+    std::vector<Document> m_documents;
+    // sorted words, the documents of m_words[i] are in m_postings[m_offsets[i], m_offsets[i+1])
+    std::vector<std::string> m_words;
+    std::vector<std::uint32_t> m_offsets;
+    std::vector<std::uint32_t> m_postings;
+    // count of the query words matched by each document
+    mutable std::vector<std::uint8_t> m_marks;
+    // reused while adding documents
+    std::string m_word;
+    LDtkProjectObjects::FieldValues m_values;
+};
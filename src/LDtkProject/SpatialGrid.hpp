@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Rect.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Uniform grid bucketing items by their bounds. Queries return items in insertion order.
+template <typename T>
+class SpatialGrid {
+public:
+    explicit SpatialGrid(float cell_size = 256.f) : m_cell_size(std::max(cell_size, 1.f))
+    {}
+
+    void insert(const T& value, const Rect& bounds) {
+        const auto index = static_cast<std::uint32_t>(m_items.size());
+        m_items.push_back({value, bounds});
+        const auto [min, max] = cellRange(bounds);
+        for (auto y = min.y; y <= max.y; ++y)
+            for (auto x = min.x; x <= max.x; ++x)
+                m_cells[key(x, y)].push_back(index);
+    }
+
+    // returns the last inserted item containing the point, nullptr if none
+    const T* pick(const glm::vec2& point) const {
+        const auto cell = cellOf(point);
+        const auto it = m_cells.find(key(cell.x, cell.y));
+        if (it == m_cells.end())
+            return nullptr;
+        for (auto index = it->second.rbegin(); index != it->second.rend(); ++index) {
+            if (m_items[*index].bounds.contains(point))
+                return &m_items[*index].value;
+        }
+        return nullptr;
+    }
+
+    void query(const Rect& area, std::vector<T>& result) const {
+        result.clear();
+        const auto span = glm::floor((area.pos + area.size) / m_cell_size) - glm::floor(area.pos / m_cell_size) + 1.f;
+
+        // when the area spans more cells than there are items, a linear scan is cheaper
+        if (static_cast<double>(span.x) * static_cast<double>(span.y) > static_cast<double>(m_items.size())) {
+            for (const auto& item : m_items) {
+                if (area.intersects(item.bounds))
+                    result.push_back(item.value);
+            }
+            return;
+        }
+
+        const auto [min, max] = cellRange(area);
+        m_scratch.clear();
+        for (auto y = min.y; y <= max.y; ++y) {
+            for (auto x = min.x; x <= max.x; ++x) {
+                const auto it = m_cells.find(key(x, y));
+                if (it != m_cells.end())
+                    m_scratch.insert(m_scratch.end(), it->second.begin(), it->second.end());
+            }
+        }
+        std::sort(m_scratch.begin(), m_scratch.end());
+        m_scratch.erase(std::unique(m_scratch.begin(), m_scratch.end()), m_scratch.end());
+        for (auto index : m_scratch) {
+            if (area.intersects(m_items[index].bounds))
+                result.push_back(m_items[index].value);
+        }
+    }
+
+    std::size_t size() const {
+        return m_items.size();
+    }
+
+private:
+    struct Item {
+        T value;
+        Rect bounds;
+    };
+
+    glm::vec<2, std::int32_t> cellOf(const glm::vec2& point) const {
+        return {static_cast<std::int32_t>(std::floor(point.x / m_cell_size)),
+                static_cast<std::int32_t>(std::floor(point.y / m_cell_size))};
+    }
+
+    std::pair<glm::vec<2, std::int32_t>, glm::vec<2, std::int32_t>> cellRange(const Rect& bounds) const {
+        return {cellOf(bounds.pos), cellOf(bounds.pos + bounds.size)};
+    }
+
+    static std::int64_t key(std::int32_t x, std::int32_t y) {
+        return (static_cast<std::int64_t>(x) << 32) | static_cast<std::uint32_t>(y);
+    }
+
+    float m_cell_size;
+    std::vector<Item> m_items;
+    std::unordered_map<std::int64_t, std::vector<std::uint32_t>> m_cells;
+    mutable std::vector<std::uint32_t> m_scratch;
+};
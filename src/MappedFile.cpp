@@ -0,0 +1,63 @@
+#include "MappedFile.hpp"
+
+#include <fstream>
+#include <iterator>
+
+#if !defined(_WIN32) && !defined(EMSCRIPTEN)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define MAPPED_FILE_MMAP
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path, bool sequential) {
+    close();
+#if defined(MAPPED_FILE_MMAP)
+    const auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat status{};
+    if (::fstat(fd, &status) == 0 && status.st_size > 0) {
+        auto* mapping = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            m_data = static_cast<const std::uint8_t*>(mapping);
+            m_size = static_cast<std::size_t>(status.st_size);
+            if (sequential)
+                ::madvise(mapping, m_size, MADV_SEQUENTIAL);
+        }
+    }
+    ::close(fd);
+    return m_data != nullptr;
+#else
+    (void)sequential;
+    return read(path);
+#endif
+}
+
+bool MappedFile::read(const std::string& path) {
+    close();
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    m_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (!m_buffer.empty()) {
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+    }
+    return m_data != nullptr;
+}
+
+void MappedFile::close() {
+#if defined(MAPPED_FILE_MMAP)
+    if (m_data != nullptr)
+        ::munmap(const_cast<std::uint8_t*>(m_data), m_size);
+#endif
+    m_buffer = {};
+    m_data = nullptr;
+    m_size = 0;
+}
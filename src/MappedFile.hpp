@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Read-only file mapped in memory, its pages are loaded by the system when first accessed
+// and can be dropped under memory pressure since they are backed by the file.
+// Systems without mmap read the file into a buffer instead.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // sequential hints the system to read ahead, for files that are read once from start to end
+    bool open(const std::string& path, bool sequential = false);
+    // reads the file into a buffer instead, for files that may be truncated while in use:
+    // accessing a mapped page past the new end of the file raises SIGBUS
+    bool read(const std::string& path);
+    void close();
+
+    const std::uint8_t* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+    std::string_view view() const { return {reinterpret_cast<const char*>(m_data), m_size}; }
+    bool isOpen() const { return m_data != nullptr; }
+
+private:
+    const std::uint8_t* m_data = nullptr;
+    std::size_t m_size = 0;
+    std::vector<std::uint8_t> m_buffer;
+};
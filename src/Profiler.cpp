@@ -0,0 +1,224 @@
+#include "Profiler.hpp"
+#include "Renderer/GL.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// timer queries are not part of WebGL 2
+#if !defined(EMSCRIPTEN)
+    #define PROFILER_GPU_QUERIES
+#endif
+
+#if defined(PROFILER_COUNT_ALLOCATIONS)
+namespace {
+    // per thread, so that the workers loading projects don't show up in the frames
+    thread_local std::size_t allocations_count = 0;
+}
+
+// the array, nothrow and sized versions forward to these ones
+void* operator new(std::size_t size) {
+    allocations_count++;
+    if (auto* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+#endif
+
+Profiler::Profiler() : m_start(std::chrono::steady_clock::now())
+{}
+
+Profiler::~Profiler() {
+#if defined(PROFILER_GPU_QUERIES)
+    for (auto& query : m_queries)
+        if (query.id != 0)
+            glDeleteQueries(1, &query.id);
+#endif
+}
+
+Profiler& Profiler::instance() {
+    static Profiler instance;
+    return instance;
+}
+
+double Profiler::now() const {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_start).count();
+}
+
+auto Profiler::current() -> Frame& {
+    return m_frames[m_frame % frames_count];
+}
+
+Profiler::Scope::Scope(const char* name) : m_name(name), m_begin_us(instance().now())
+{}
+
+Profiler::Scope::~Scope() {
+    auto& profiler = instance();
+    profiler.current().samples.push_back({m_name, m_begin_us, profiler.now()});
+}
+
+void Profiler::beginFrame() {
+    auto& profiler = instance();
+    profiler.collectGpuResults();
+
+    auto& frame = profiler.current();
+    // samples keep their capacity, so that recording does not allocate once warmed up
+    frame.samples.clear();
+    frame.begin_us = profiler.now();
+    frame.end_us = frame.begin_us;
+    frame.gpu_begin_us = 0;
+    frame.gpu_ms = -1;
+    frame.draw_calls = 0;
+    frame.vertices = 0;
+    frame.texture_binds = 0;
+    frame.allocations = 0;
+#if defined(PROFILER_COUNT_ALLOCATIONS)
+    profiler.m_frame_allocations = allocations_count;
+#endif
+}
+
+void Profiler::endFrame() {
+    auto& profiler = instance();
+    profiler.current().end_us = profiler.now();
+#if defined(PROFILER_COUNT_ALLOCATIONS)
+    profiler.current().allocations = allocations_count - profiler.m_frame_allocations;
+#endif
+    profiler.m_frame++;
+}
+
+void Profiler::beginGpu() {
+    auto& profiler = instance();
+    profiler.current().gpu_begin_us = profiler.now();
+#if defined(PROFILER_GPU_QUERIES)
+    // results arrive a few frames later, the frame is skipped when all the queries are still in flight
+    auto it = std::find_if(profiler.m_queries.begin(), profiler.m_queries.end(), [](const Query& query) {
+        return !query.pending;
+    });
+    if (it == profiler.m_queries.end())
+        return;
+    if (it->id == 0)
+        glGenQueries(1, &it->id);
+    it->frame = profiler.m_frame;
+    it->pending = true;
+    profiler.m_active_query = &*it;
+    glBeginQuery(GL_TIME_ELAPSED, it->id);
+#endif
+}
+
+void Profiler::endGpu() {
+#if defined(PROFILER_GPU_QUERIES)
+    auto& profiler = instance();
+    if (profiler.m_active_query == nullptr)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    profiler.m_active_query = nullptr;
+#endif
+}
+
+void Profiler::collectGpuResults() {
+#if defined(PROFILER_GPU_QUERIES)
+    for (auto& query : m_queries) {
+        if (!query.pending)
+            continue;
+        GLint available = 0;
+        glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue;
+        GLuint64 elapsed_ns = 0;
+        glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &elapsed_ns);
+        query.pending = false;
+        // the frame may have been overwritten already
+        if (m_frame - query.frame < frames_count)
+            m_frames[query.frame % frames_count].gpu_ms = static_cast<double>(elapsed_ns) / 1e6;
+    }
+#endif
+}
+
+void Profiler::countDraw(std::size_t vertices) {
+    auto& frame = instance().current();
+    frame.draw_calls++;
+    frame.vertices += vertices;
+}
+
+void Profiler::countTextureBind() {
+    instance().current().texture_binds++;
+}
+
+std::size_t Profiler::getFramesCount() {
+    return std::min(instance().m_frame, frames_count);
+}
+
+auto Profiler::getFrame(std::size_t age) -> const Frame& {
+    auto& profiler = instance();
+    return profiler.m_frames[(profiler.m_frame - 1 - age) % frames_count];
+}
+
+bool Profiler::saveTrace(const std::string& path) {
+    std::ofstream file(path);
+    if (!file)
+        return false;
+
+    // CPU stages on the first track, GPU time on the second one
+    file << "{\"traceEvents\":[";
+    auto first = true;
+    auto event = [&](const char* name, int tid, double begin_us, double duration_us) {
+        file << (first ? "\n" : ",\n") << "{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << tid
+             << ",\"ts\":" << begin_us << ",\"dur\":" << duration_us << "}";
+        first = false;
+    };
+    for (auto age = getFramesCount(); age-- > 0;) {
+        const auto& frame = getFrame(age);
+        event("frame", 0, frame.begin_us, frame.end_us - frame.begin_us);
+        for (const auto& sample : frame.samples)
+            event(sample.name, 0, sample.begin_us, sample.end_us - sample.begin_us);
+        if (frame.gpu_ms >= 0)
+            event("world draw", 1, frame.gpu_begin_us, frame.gpu_ms * 1000.);
+        file << ",\n{\"name\":\"draws\",\"ph\":\"C\",\"pid\":0,\"ts\":" << frame.begin_us
+             << ",\"args\":{\"draw_calls\":" << frame.draw_calls << ",\"vertices\":" << frame.vertices
+             << ",\"texture_binds\":" << frame.texture_binds << ",\"allocations\":" << frame.allocations << "}}";
+    }
+    file << "\n],\n\"displayTimeUnit\":\"ms\"}\n";
+    return static_cast<bool>(file);
+}
+
+void Profiler::resetPeakMemory() {
+#if defined(__linux__)
+    std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+long Profiler::getPeakMemoryKiB() {
+#if defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0)
+            return std::stol(line.substr(6));
+    }
+    return 0;
+#elif defined(__unix__) || defined(__APPLE__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
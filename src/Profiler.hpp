@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// debug builds count the heap allocations of the main thread, by replacing the global operator new
+// (unless PROFILER_NO_ALLOCATIONS_COUNT is defined, for the programs replacing it themselves)
+#if !defined(NDEBUG) && !defined(PROFILER_NO_ALLOCATIONS_COUNT)
+    #define PROFILER_COUNT_ALLOCATIONS
+#endif
+
+// Per-frame instrumentation: CPU time of the frame stages, GPU time of the world draw and draw counters.
+// The last frames are kept in a ring buffer, they can be saved as a Chrome trace (chrome://tracing, Perfetto).
+class Profiler {
+public:
+    static constexpr std::size_t frames_count = 240;
+
+    struct Sample {
+        const char* name;
+        double begin_us;
+        double end_us;
+    };
+
+    struct Frame {
+        double begin_us = 0;
+        double end_us = 0;
+        std::vector<Sample> samples;
+        // negative until the GPU result is available, or when timer queries are not supported
+        double gpu_begin_us = 0;
+        double gpu_ms = -1;
+        int draw_calls = 0;
+        std::size_t vertices = 0;
+        int texture_binds = 0;
+        // heap allocations of the main thread during the frame, 0 when they are not counted
+        std::size_t allocations = 0;
+    };
+
+    // measures the CPU time spent until its destruction, name must outlive the profiler
+    class Scope {
+    public:
+        explicit Scope(const char* name);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        const char* m_name;
+        double m_begin_us;
+    };
+
+    Profiler(const Profiler&) = delete;
+    Profiler(Profiler&&) = delete;
+    ~Profiler();
+
+    static void beginFrame();
+    static void endFrame();
+    // GL timer query around the world draw, must be called from the GL thread
+    static void beginGpu();
+    static void endGpu();
+
+    static void countDraw(std::size_t vertices);
+    static void countTextureBind();
+    static constexpr bool countsAllocations() {
+#if defined(PROFILER_COUNT_ALLOCATIONS)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // number of ended frames kept, and those frames from the most recent (age 0)
+    static std::size_t getFramesCount();
+    static const Frame& getFrame(std::size_t age);
+
+    static bool saveTrace(const std::string& path);
+
+    // peak resident set size of the process, reset where the system allows it (Linux), 0 when unknown
+    static void resetPeakMemory();
+    static long getPeakMemoryKiB();
+
+private:
+    Profiler();
+    static Profiler& instance();
+    double now() const;
+    Frame& current();
+    void collectGpuResults();
+
+    struct Query {
+        unsigned id = 0;
+        std::size_t frame = 0;
+        bool pending = false;
+    };
+
+    std::chrono::steady_clock::time_point m_start;
+    std::array<Frame, frames_count> m_frames;
+    // index of the frame being recorded, since the start
+    std::size_t m_frame = 0;
+    std::size_t m_frame_allocations = 0;
+    std::array<Query, 4> m_queries;
+    Query* m_active_query = nullptr;
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+struct Rect {
+    glm::vec2 pos;
+    glm::vec2 size;
+
+    bool contains(const glm::vec2& point) const {
+        return point.x >= pos.x && point.y >= pos.y
+            && point.x < pos.x + size.x && point.y < pos.y + size.y;
+    }
+
+    bool intersects(const Rect& other) const {
+        return pos.x < other.pos.x + other.size.x && other.pos.x < pos.x + size.x
+            && pos.y < other.pos.y + other.size.y && other.pos.y < pos.y + size.y;
+    }
+};
@@ -0,0 +1,251 @@
+#include "BatchRenderer.hpp"
+#include "Profiler.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+BatchRenderer::BatchRenderer(LevelCache& cache, const std::vector<TextureManager::Handle>& textures) :
+LevelCache::Resource(cache) {
+    m_shader.load(vert_shader, frag_shader);
+    m_atlas.build(textures);
+}
+
+BatchRenderer::~BatchRenderer() {
+    clear();
+}
+
+void BatchRenderer::begin(const glm::vec2& window_size, const glm::vec2& offset, const glm::vec3& transform, bool entities) {
+    m_shader.bind();
+    m_shader.setUniform("window_size", window_size);
+    m_shader.setUniform("offset", offset);
+    m_shader.setUniform("transform", transform);
+    m_shader.setUniform("show_entities", entities ? 1.f : 0.f);
+}
+
+void BatchRenderer::setTint(const glm::vec4& color, float dim, const Level* hovered, const Level* selected) {
+    m_color = color;
+    m_dim = dim;
+    m_hovered = hovered;
+    m_selected = selected;
+}
+
+void BatchRenderer::build(const Level& level, LevelGeometry& geometry) const {
+    std::vector<LDtkProjectObjects::Quad> quads;
+    auto append = [&](std::vector<Vertex>& vertices, const glm::vec2& tex_offset, float entity) {
+        vertices.reserve(quads.size() * 4);
+        for (const auto& quad : quads) {
+            for (const auto& v : quad) {
+                auto tex = v.tex;
+                if (tex != glm::vec2(-1.f, -1.f))
+                    tex += tex_offset;
+                // the level index is set when the level is merged
+                vertices.push_back({v.pos, tex, v.col, 0.f, entity});
+            }
+        }
+        geometry.vertices += vertices.size();
+    };
+
+    geometry.layers.resize(level.layers.size());
+    for (std::size_t l = 0; l < level.layers.size(); ++l) {
+        const auto& layer = level.layers[l];
+        auto& layer_geometry = geometry.layers[l];
+        if (IntGridRenderer::isPureIntGrid(layer)) {
+            layer_geometry.intgrid = &layer;
+            continue;
+        }
+        quads.clear();
+        LDtkProjectObjects::Layer::buildTilesQuads(layer.data, level.bounds.pos, quads);
+        if (!quads.empty()) {
+            if (const auto* region = m_atlas.getRegion(layer.texture_path)) {
+                layer_geometry.page = region->page;
+                append(layer_geometry.tiles, region->offset, 0.f);
+            }
+        }
+        quads.clear();
+        LDtkProjectObjects::Layer::buildEntitiesQuads(layer.data, level.bounds.pos, quads);
+        append(layer_geometry.entities, {0, 0}, 1.f);
+    }
+}
+
+void BatchRenderer::merge(const std::vector<const Level*>& levels, Batch& batch) {
+    batch.levels = levels;
+    batch.draws.clear();
+    m_vertices.clear();
+    m_indices.clear();
+
+    auto append = [&](const std::vector<Vertex>& vertices, int page, std::size_t level_index) {
+        if (vertices.empty())
+            return;
+        auto& draws = batch.draws;
+        if (draws.empty() || draws.back().intgrid != nullptr
+            || (page >= 0 && draws.back().page >= 0 && draws.back().page != page))
+            draws.push_back({page, static_cast<GLsizei>(m_indices.size()), 0, nullptr, nullptr});
+        if (draws.back().page < 0)
+            draws.back().page = page;
+
+        for (std::size_t i = 0; i < vertices.size(); i += 4) {
+            const auto first = static_cast<std::uint32_t>(m_vertices.size());
+            for (std::size_t v = i; v < i + 4; ++v) {
+                m_vertices.push_back(vertices[v]);
+                m_vertices.back().level = static_cast<float>(level_index);
+            }
+            m_indices.insert(m_indices.end(), {first, first + 1, first + 2, first, first + 2, first + 3});
+        }
+        draws.back().count += static_cast<GLsizei>(vertices.size() / 4 * 6);
+    };
+
+    // layers are sorted from bottom to top across all the levels, so that the draw order is the same as per
+    // level rendering. The levels don't overlap, the pure IntGrid layers of an index are drawn after its tiles
+    std::size_t max_layers = 0;
+    for (const auto* level : levels)
+        max_layers = std::max(max_layers, m_geometries.at(level).layers.size());
+    for (auto l = max_layers; l-- > 0;) {
+        for (std::size_t i = 0; i < levels.size(); ++i) {
+            const auto& layers = m_geometries.at(levels[i]).layers;
+            if (l >= layers.size())
+                continue;
+            append(layers[l].tiles, layers[l].page, i);
+            append(layers[l].entities, -1, i);
+        }
+        for (const auto* level : levels) {
+            const auto& layers = m_geometries.at(level).layers;
+            if (l < layers.size() && layers[l].intgrid != nullptr)
+                batch.draws.push_back({-1, static_cast<GLsizei>(m_indices.size()), 0, layers[l].intgrid, level});
+        }
+    }
+
+    if (batch.vao == 0) {
+        glGenVertexArrays(1, &batch.vao);
+        glGenBuffers(1, &batch.vbo);
+        glGenBuffers(1, &batch.ebo);
+        glBindVertexArray(batch.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, batch.vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch.ebo);
+
+        const auto stride = static_cast<GLsizei>(sizeof(Vertex));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(Vertex, pos)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(Vertex, tex)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(Vertex, col)));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(Vertex, level)));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(Vertex, entity)));
+    } else {
+        glBindVertexArray(batch.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, batch.vbo);
+    }
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_vertices.size() * sizeof(Vertex)), m_vertices.data(), GL_DYNAMIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_indices.size() * sizeof(std::uint32_t)), m_indices.data(), GL_DYNAMIC_DRAW);
+    glBindVertexArray(0);
+}
+
+void BatchRenderer::prepare(int depth, const std::vector<const Level*>& levels, ThreadPool& pool) {
+    m_missing.clear();
+    for (const auto* level : levels) {
+        if (m_geometries.count(level) == 0)
+            m_missing.push_back(level);
+    }
+    if (!m_missing.empty()) {
+        m_built.resize(m_missing.size());
+        pool.parallelFor(m_missing.size(), [this](std::size_t i) {
+            build(*m_missing[i], m_built[i]);
+        });
+        for (std::size_t i = 0; i < m_missing.size(); ++i)
+            m_geometries[m_missing[i]] = std::move(m_built[i]);
+        m_built.clear();
+    }
+
+    auto& batch = m_batches[depth];
+    if (batch.vao == 0 || batch.levels != levels)
+        merge(levels, batch);
+}
+
+void BatchRenderer::render(int depth, IntGridRenderer* intgrid) {
+    const auto it = m_batches.find(depth);
+    if (it == m_batches.end())
+        return;
+    const auto& batch = it->second;
+
+    auto levelIndex = [&](const Level* level) {
+        const auto level_it = std::find(batch.levels.begin(), batch.levels.end(), level);
+        return level_it != batch.levels.end() ? static_cast<float>(level_it - batch.levels.begin()) : -1.f;
+    };
+
+    m_shader.bind();
+    m_shader.setUniform("color", m_color);
+    m_shader.setUniform("dim", m_dim);
+    m_shader.setUniform("highlighted", glm::vec2(levelIndex(m_hovered), levelIndex(m_selected)));
+    glBindVertexArray(batch.vao);
+    for (const auto& draw : batch.draws) {
+        if (draw.intgrid != nullptr) {
+            if (intgrid == nullptr)
+                continue;
+            auto color = m_color;
+            if (draw.level != m_hovered && draw.level != m_selected)
+                color = glm::vec4(color.r * m_dim, color.g * m_dim, color.b * m_dim, color.a);
+            intgrid->setColor(color);
+            if (intgrid->render(*draw.intgrid)) {
+                m_shader.bind();
+                glBindVertexArray(batch.vao);
+            }
+            continue;
+        }
+        if (draw.page >= 0) {
+            m_shader.setUniform("texture_size", m_atlas.getPageSize(draw.page));
+            m_atlas.bindPage(draw.page);
+            Profiler::countTextureBind();
+        } else {
+            m_shader.setUniform("texture_size", glm::vec2(0, 0));
+        }
+        glDrawElements(GL_TRIANGLES, draw.count, GL_UNSIGNED_INT,
+                       reinterpret_cast<void*>(static_cast<std::size_t>(draw.first) * sizeof(std::uint32_t)));
+        // 6 indices per quad of 4 vertices
+        Profiler::countDraw(static_cast<std::size_t>(draw.count) / 6 * 4);
+    }
+    glBindVertexArray(0);
+}
+
+void BatchRenderer::destroy(Batch& batch) {
+    glDeleteBuffers(1, &batch.ebo);
+    glDeleteBuffers(1, &batch.vbo);
+    glDeleteVertexArrays(1, &batch.vao);
+}
+
+void BatchRenderer::clear() {
+    for (auto& [_, batch] : m_batches)
+        destroy(batch);
+    m_batches.clear();
+    m_geometries.clear();
+}
+
+std::size_t BatchRenderer::getMemory(const Level& level) const {
+    const auto it = m_geometries.find(&level);
+    if (it == m_geometries.end())
+        return 0;
+    // the geometry of the level, and its copy in the buffer of its depth, with 6 indices per quad
+    const auto vertices = it->second.vertices;
+    return vertices * sizeof(Vertex) * 2 + vertices / 4 * 6 * sizeof(std::uint32_t);
+}
+
+void BatchRenderer::release(const Level& level) {
+    if (m_geometries.erase(&level) == 0)
+        return;
+    // the buffers holding the level are merged again when drawn
+    for (auto it = m_batches.begin(); it != m_batches.end();) {
+        if (std::find(it->second.levels.begin(), it->second.levels.end(), &level) != it->second.levels.end()) {
+            destroy(it->second);
+            it = m_batches.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::size_t BatchRenderer::getAtlasMemory() const {
+    return m_atlas.getMemory();
+}
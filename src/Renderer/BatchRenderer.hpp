@@ -0,0 +1,166 @@
+#pragma once
+
+#include "GL.hpp"
+#include "IntGridRenderer.hpp"
+#include "TextureAtlas.hpp"
+#include "LDtkProject/LDtkProjectObjects.hpp"
+#include "LDtkProject/LevelCache.hpp"
+
+#include <sogl/Shader.hpp>
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+class ThreadPool;
+
+// Merges the tiles and entities of the visible levels of a depth into a single vertex buffer, ordered by layer,
+// textured from one atlas holding every tileset of the project: a depth is drawn with one draw call per atlas page.
+// The geometry of each level is built once and kept until the level is evicted from the cache, the buffer of a
+// depth is merged again from it when its visible levels change.
+// Each vertex carries the index of its level in the buffer, compared in the shader to the highlighted levels.
+class BatchRenderer : public LevelCache::Resource {
+public:
+    using Level = LDtkProjectObjects::Level;
+
+    BatchRenderer(LevelCache& cache, const std::vector<TextureManager::Handle>& textures);
+    ~BatchRenderer() override;
+
+    void begin(const glm::vec2& window_size, const glm::vec2& offset, const glm::vec3& transform, bool entities);
+    // tint of the next depth drawn, the color of the levels other than hovered and selected is multiplied by dim
+    void setTint(const glm::vec4& color, float dim, const Level* hovered, const Level* selected);
+
+    // builds the geometry of the levels that don't have one on the pool, then merges the levels into the buffer
+    // of the depth, unless they are the ones it already holds
+    void prepare(int depth, const std::vector<const Level*>& levels, ThreadPool& pool);
+    // draws a prepared depth, its pure IntGrid layers are drawn in order with intgrid when not null
+    void render(int depth, IntGridRenderer* intgrid);
+
+    void clear();
+
+    std::size_t getMemory(const Level& level) const override;
+    void release(const Level& level) override;
+    std::size_t getAtlasMemory() const;
+
+private:
+    struct Vertex {
+        glm::vec2 pos;
+        glm::vec2 tex;
+        glm::vec4 col;
+        float level;
+        float entity;
+    };
+
+    // geometry of a layer of a level, its tiles being on an atlas page (-1 if none),
+    // or a pure IntGrid layer drawn by the IntGrid renderer
+    struct LayerGeometry {
+        int page = -1;
+        std::vector<Vertex> tiles;
+        std::vector<Vertex> entities;
+        const LDtkProjectObjects::Layer* intgrid = nullptr;
+    };
+
+    struct LevelGeometry {
+        // in the order of the level layers, from the top one
+        std::vector<LayerGeometry> layers;
+        std::size_t vertices = 0;
+    };
+
+    // a range of indices drawn with an atlas page (-1 for entities only),
+    // or a pure IntGrid layer of a level drawn between the ranges
+    struct Draw {
+        int page;
+        GLsizei first;
+        GLsizei count;
+        const LDtkProjectObjects::Layer* intgrid;
+        const Level* level;
+    };
+
+    struct Batch {
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        GLuint ebo = 0;
+        // merged levels, in the order of their vertices level index
+        std::vector<const Level*> levels;
+        std::vector<Draw> draws;
+    };
+
+    void build(const Level& level, LevelGeometry& geometry) const;
+    void merge(const std::vector<const Level*>& levels, Batch& batch);
+    static void destroy(Batch& batch);
+
+    sogl::Shader m_shader;
+    TextureAtlas m_atlas;
+    std::map<const Level*, LevelGeometry> m_geometries;
+    std::map<int, Batch> m_batches;
+    std::vector<const Level*> m_missing;
+    std::vector<LevelGeometry> m_built;
+    // reused by the merges
+    std::vector<Vertex> m_vertices;
+    std::vector<std::uint32_t> m_indices;
+
+    glm::vec4 m_color = {1.f, 1.f, 1.f, 1.f};
+    float m_dim = 1.f;
+    const Level* m_hovered = nullptr;
+    const Level* m_selected = nullptr;
+
+    static constexpr auto vert_shader = GLSL(330 core,
+        precision highp float;
+        uniform vec2 window_size;
+        uniform vec2 texture_size;
+        uniform vec3 transform;
+        uniform vec2 offset;
+        uniform vec2 highlighted;
+        uniform float dim;
+        uniform float show_entities;
+
+        layout (location = 0) in vec2 i_pos;
+        layout (location = 1) in vec2 i_tex;
+        layout (location = 2) in vec4 i_col;
+        layout (location = 3) in float i_level;
+        layout (location = 4) in float i_entity;
+
+        out vec2 tex;
+        out vec4 col;
+
+        void main() {
+            vec2 pos = i_pos.xy / window_size.xy;
+            pos.xy += transform.xy;
+            pos.xy *= 2.*transform.z;
+            pos.xy += offset.xy / window_size.xy;
+
+            tex.xy = i_tex.xy;
+            if (tex.xy != vec2(-1., -1.) && texture_size.xy != vec2(0, 0))
+                tex.xy /= texture_size.xy;
+            else
+                tex.xy = vec2(-1., -1.);
+
+            col = i_col;
+            if (i_level != highlighted.x && i_level != highlighted.y)
+                col.rgb *= dim;
+
+            if (i_entity > 0.5 && show_entities < 0.5)
+                gl_Position = vec4(2., 2., 2., 1.);
+            else
+                gl_Position = vec4(pos.x, -pos.y, 0, 1.0);
+        }
+    );
+    static constexpr auto frag_shader = GLSL(330 core,
+        precision highp float;
+        uniform sampler2D texture0;
+        uniform vec4 color;
+
+        in vec2 tex;
+        in vec4 col;
+
+        out vec4 fragColor;
+
+        void main() {
+            vec4 tex_color = vec4(1.f, 1.f, 1.f, 1.f);
+            if (tex.xy != vec2(-1, -1))
+                tex_color = texture(texture0, tex);
+
+            fragColor = col * tex_color * color;
+        }
+    );
+};
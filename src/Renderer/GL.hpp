@@ -0,0 +1,10 @@
+#pragma once
+
+// OpenGL functions, loaded by sogl
+#if defined(EMSCRIPTEN)
+    #include <GLES3/gl3.h>
+#elif __has_include(<glad/gl.h>)
+    #include <glad/gl.h>
+#else
+    #include <glad/glad.h>
+#endif
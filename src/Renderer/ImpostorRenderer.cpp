@@ -0,0 +1,153 @@
+#include "ImpostorRenderer.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+ImpostorRenderer::ImpostorRenderer(LevelCache& cache) : LevelCache::Resource(cache) {
+    m_shader.load(vert_shader, frag_shader);
+    m_shader.bind();
+    m_shader.setUniform("impostor", 0);
+
+    const float corners[] = {0.f, 0.f, 1.f, 0.f, 0.f, 1.f, 1.f, 1.f};
+    glGenVertexArrays(1, &m_quad_vao);
+    glGenBuffers(1, &m_quad_vbo);
+    glBindVertexArray(m_quad_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_quad_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    glBindVertexArray(0);
+
+    glGenFramebuffers(1, &m_framebuffer);
+}
+
+ImpostorRenderer::~ImpostorRenderer() {
+    clear();
+    glDeleteFramebuffers(1, &m_framebuffer);
+    glDeleteBuffers(1, &m_quad_vbo);
+    glDeleteVertexArrays(1, &m_quad_vao);
+}
+
+void ImpostorRenderer::begin(const glm::vec2& window_size, const glm::vec2& offset, const glm::vec3& transform,
+                             bool entities, bool intgrid) {
+    if (entities != m_entities || intgrid != m_intgrid) {
+        clear();
+        m_entities = entities;
+        m_intgrid = intgrid;
+    }
+    m_shader.bind();
+    m_shader.setUniform("window_size", window_size);
+    m_shader.setUniform("offset", offset);
+    m_shader.setUniform("transform", transform);
+}
+
+void ImpostorRenderer::setColor(const glm::vec4& color) {
+    m_shader.bind();
+    m_shader.setUniform("color", color);
+}
+
+bool ImpostorRenderer::has(const LDtkProjectObjects::Level& level) const {
+    return m_impostors.count(&level) > 0;
+}
+
+void ImpostorRenderer::build(const LDtkProjectObjects::Level& level, const DrawLevel& draw) {
+    invalidate(level);
+    const auto width = std::clamp(static_cast<int>(std::ceil(level.bounds.size.x * scale)), 1, max_texture_size);
+    const auto height = std::clamp(static_cast<int>(std::ceil(level.bounds.size.y * scale)), 1, max_texture_size);
+
+    auto& impostor = m_impostors[&level];
+    glGenTextures(1, &impostor.texture);
+    glBindTexture(GL_TEXTURE_2D, impostor.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // mipmaps add a third of the base level
+    impostor.memory = static_cast<std::size_t>(width) * height * 4 * 4 / 3;
+    m_textures_memory += impostor.memory;
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLfloat clear_color[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_color);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, impostor.texture, 0);
+    glViewport(0, 0, width, height);
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // the main shader maps [0, window_size] to the viewport once translated by the transform,
+    // the level bounds are mapped to the whole texture
+    const auto transform = glm::vec3(-level.bounds.pos.x / level.bounds.size.x - 0.5f,
+                                     -level.bounds.pos.y / level.bounds.size.y - 0.5f, 1.f);
+    draw(level, level.bounds.size, transform);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+    glBindTexture(GL_TEXTURE_2D, impostor.texture);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+bool ImpostorRenderer::render(const LDtkProjectObjects::Level& level) {
+    const auto it = m_impostors.find(&level);
+    if (it == m_impostors.end())
+        return false;
+
+    m_shader.bind();
+    m_shader.setUniform("level_pos", level.bounds.pos);
+    m_shader.setUniform("level_size", level.bounds.size);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, it->second.texture);
+    Profiler::countTextureBind();
+
+    glBindVertexArray(m_quad_vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    Profiler::countDraw(4);
+    glBindVertexArray(0);
+    return true;
+}
+
+void ImpostorRenderer::transfer(const LDtkProjectObjects::Level& from, const LDtkProjectObjects::Level& to) {
+    auto node = m_impostors.extract(&from);
+    if (node.empty())
+        return;
+    node.key() = &to;
+    m_impostors.insert(std::move(node));
+}
+
+void ImpostorRenderer::invalidate(const LDtkProjectObjects::Level& level) {
+    const auto it = m_impostors.find(&level);
+    if (it == m_impostors.end())
+        return;
+    glDeleteTextures(1, &it->second.texture);
+    m_textures_memory -= it->second.memory;
+    m_impostors.erase(it);
+}
+
+void ImpostorRenderer::clear() {
+    for (auto& [_, impostor] : m_impostors)
+        glDeleteTextures(1, &impostor.texture);
+    m_impostors.clear();
+    m_textures_memory = 0;
+}
+
+std::size_t ImpostorRenderer::getMemory(const LDtkProjectObjects::Level& level) const {
+    const auto it = m_impostors.find(&level);
+    return it != m_impostors.end() ? it->second.memory : 0;
+}
+
+void ImpostorRenderer::release(const LDtkProjectObjects::Level& level) {
+    invalidate(level);
+}
+
+std::size_t ImpostorRenderer::getCount() const {
+    return m_impostors.size();
+}
+
+std::size_t ImpostorRenderer::getTexturesMemory() const {
+    return m_textures_memory;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "GL.hpp"
+#include "LDtkProject/LDtkProjectObjects.hpp"
+#include "LDtkProject/LevelCache.hpp"
+
+#include <sogl/Shader.hpp>
+
+#include <functional>
+#include <unordered_map>
+
+// Draws zoomed out levels as a single textured quad. Each level is rendered once into an offscreen texture
+// at a fraction of its size (its impostor), which is reused until the level changes or is evicted from the cache.
+class ImpostorRenderer : public LevelCache::Resource {
+public:
+    // draws the layers of a level with the given main shader uniforms, the level filling the viewport
+    using DrawLevel = std::function<void(const LDtkProjectObjects::Level&, const glm::vec2& window_size, const glm::vec3& transform)>;
+
+    // scale of the impostors, they are used when the camera zoom is below it
+    static constexpr auto scale = 0.25f;
+    static constexpr auto max_texture_size = 2048;
+
+    explicit ImpostorRenderer(LevelCache& cache);
+    ~ImpostorRenderer() override;
+    ImpostorRenderer(const ImpostorRenderer&) = delete;
+    ImpostorRenderer& operator=(const ImpostorRenderer&) = delete;
+
+    // impostors are rebuilt when the drawn content changes
+    void begin(const glm::vec2& window_size, const glm::vec2& offset, const glm::vec3& transform,
+               bool entities, bool intgrid);
+    void setColor(const glm::vec4& color);
+
+    bool has(const LDtkProjectObjects::Level& level) const;
+    // renders the level into its impostor, its geometry must be uploaded
+    void build(const LDtkProjectObjects::Level& level, const DrawLevel& draw);
+    // returns false when the level has no impostor
+    bool render(const LDtkProjectObjects::Level& level);
+
+    // moves the impostor of a level to the same level of a reloaded project
+    void transfer(const LDtkProjectObjects::Level& from, const LDtkProjectObjects::Level& to);
+    void invalidate(const LDtkProjectObjects::Level& level);
+    void clear();
+
+    std::size_t getMemory(const LDtkProjectObjects::Level& level) const override;
+    void release(const LDtkProjectObjects::Level& level) override;
+
+    std::size_t getCount() const;
+    std::size_t getTexturesMemory() const;
+
+private:
+    struct Impostor {
+        GLuint texture = 0;
+        std::size_t memory = 0;
+    };
+
+    sogl::Shader m_shader;
+    GLuint m_framebuffer = 0;
+    GLuint m_quad_vao = 0;
+    GLuint m_quad_vbo = 0;
+    std::unordered_map<const LDtkProjectObjects::Level*, Impostor> m_impostors;
+    std::size_t m_textures_memory = 0;
+    bool m_entities = false;
+    bool m_intgrid = false;
+
+    static constexpr auto vert_shader = GLSL(330 core,
+        precision highp float;
+        uniform vec2 window_size;
+        uniform vec3 transform;
+        uniform vec2 offset;
+        uniform vec2 level_pos;
+        uniform vec2 level_size;
+
+        layout (location = 0) in vec2 i_corner;
+
+        out vec2 tex;
+
+        void main() {
+            vec2 pos = level_pos + i_corner * level_size;
+            pos.xy /= window_size.xy;
+            pos.xy += transform.xy;
+            pos.xy *= 2.*transform.z;
+            pos.xy += offset.xy / window_size.xy;
+
+            // impostors are rendered with the top of the level on the last row
+            tex = vec2(i_corner.x, 1. - i_corner.y);
+
+            gl_Position = vec4(pos.x, -pos.y, 0, 1.0);
+        }
+    );
+    static constexpr auto frag_shader = GLSL(330 core,
+        precision highp float;
+        uniform sampler2D impostor;
+        uniform vec4 color;
+
+        in vec2 tex;
+
+        out vec4 fragColor;
+
+        void main() {
+            fragColor = texture(impostor, tex) * color;
+        }
+    );
+};
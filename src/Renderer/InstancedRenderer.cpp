@@ -0,0 +1,175 @@
+#include "InstancedRenderer.hpp"
+#include "Profiler.hpp"
+
+#include "LDtkProject/ldtk2glm.hpp"
+#include "TextureManager.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+InstancedRenderer::InstancedRenderer(LevelCache& cache) : LevelCache::Resource(cache) {
+    m_shader.load(vert_shader, frag_shader);
+
+    const float corners[] = {0.f, 0.f, 1.f, 0.f, 0.f, 1.f, 1.f, 1.f};
+    glGenBuffers(1, &m_quad_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, m_quad_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+}
+
+InstancedRenderer::~InstancedRenderer() {
+    clear();
+    glDeleteBuffers(1, &m_quad_vbo);
+}
+
+void InstancedRenderer::clear() {
+    for (auto& [_, instances] : m_layers) {
+        glDeleteBuffers(1, &instances.vbo);
+        glDeleteVertexArrays(1, &instances.vao);
+    }
+    m_layers.clear();
+    m_instances_memory = 0;
+}
+
+void InstancedRenderer::transfer(const LDtkProjectObjects::Layer& from, const LDtkProjectObjects::Layer& to) {
+    auto node = m_layers.extract(&from);
+    if (node.empty())
+        return;
+    node.key() = &to;
+    m_layers.insert(std::move(node));
+}
+
+void InstancedRenderer::invalidate(const LDtkProjectObjects::Layer& layer) {
+    const auto it = m_layers.find(&layer);
+    if (it == m_layers.end())
+        return;
+    glDeleteBuffers(1, &it->second.vbo);
+    glDeleteVertexArrays(1, &it->second.vao);
+    m_instances_memory -= static_cast<std::size_t>(it->second.count) * sizeof(Instance);
+    m_layers.erase(it);
+}
+
+std::size_t InstancedRenderer::getMemory(const LDtkProjectObjects::Level& level) const {
+    std::size_t memory = 0;
+    for (const auto& layer : level.layers) {
+        if (const auto it = m_layers.find(&layer); it != m_layers.end())
+            memory += static_cast<std::size_t>(it->second.count) * sizeof(Instance);
+    }
+    return memory;
+}
+
+void InstancedRenderer::release(const LDtkProjectObjects::Level& level) {
+    for (const auto& layer : level.layers)
+        invalidate(layer);
+}
+
+std::size_t InstancedRenderer::getInstancesMemory() const {
+    return m_instances_memory;
+}
+
+void InstancedRenderer::begin(const glm::vec2& window_size, const glm::vec2& offset, const glm::vec3& transform) {
+    m_shader.bind();
+    m_shader.setUniform("window_size", window_size);
+    m_shader.setUniform("offset", offset);
+    m_shader.setUniform("transform", transform);
+}
+
+void InstancedRenderer::setColor(const glm::vec4& color) {
+    m_shader.bind();
+    m_shader.setUniform("color", color);
+}
+
+auto InstancedRenderer::build(const LDtkProjectObjects::Layer& layer) -> LayerInstances {
+    LayerInstances result;
+    const auto& data = layer.data;
+    if (data.allTiles().empty() || layer.texture_path.empty())
+        return result;
+    const auto* texture = &TextureManager::get(layer.texture_path);
+
+    const auto& tileset = data.getTileset();
+    const auto tile_size = tileset.tile_size;
+    const auto columns = (texture->getSize().x - tileset.padding * 2 + tileset.spacing) / (tile_size + tileset.spacing);
+    if (tile_size <= 0 || columns <= 0)
+        return result;
+
+    constexpr auto max_value = static_cast<int>(std::numeric_limits<std::uint16_t>::max());
+    std::vector<Instance> instances;
+    instances.reserve(data.allTiles().size());
+    for (const auto& tile : data.allTiles()) {
+        if (tile.getPosition().x < 0 || tile.getPosition().x > data.getGridSize().x * data.getCellSize()
+            || tile.getPosition().y < 0 || tile.getPosition().y > data.getGridSize().y * data.getCellSize())
+            continue;
+        const auto verts = tile.getVertices();
+        auto pos = glm::vec2(ldtk2glm(verts[0].pos));
+        auto tex = glm::vec<2, int>(ldtk2glm(verts[0].tex));
+        for (const auto& v : verts) {
+            pos = glm::min(pos, glm::vec2(ldtk2glm(v.pos)));
+            tex = glm::min(tex, ldtk2glm(v.tex));
+        }
+        // the tile texture position must match the one computed from its id in the shader
+        const auto expected_x = tileset.padding + (tile.tileId % columns) * (tile_size + tileset.spacing);
+        const auto expected_y = tileset.padding + (tile.tileId / columns) * (tile_size + tileset.spacing);
+        if (tex.x != expected_x || tex.y != expected_y || tile.tileId < 0 || tile.tileId > max_value
+            || pos.x < 0 || pos.y < 0 || pos.x > max_value || pos.y > max_value)
+            return result;
+
+        instances.push_back({
+            static_cast<std::uint16_t>(pos.x), static_cast<std::uint16_t>(pos.y), static_cast<std::uint16_t>(tile.tileId),
+            static_cast<std::uint8_t>((tile.flipX ? 1 : 0) | (tile.flipY ? 2 : 0)), 0
+        });
+    }
+
+    glGenVertexArrays(1, &result.vao);
+    glGenBuffers(1, &result.vbo);
+    glBindVertexArray(result.vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_quad_vbo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+
+    glBindBuffer(GL_ARRAY_BUFFER, result.vbo);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(instances.size() * sizeof(Instance)), instances.data(), GL_STATIC_DRAW);
+    const auto stride = static_cast<GLsizei>(sizeof(Instance));
+    glEnableVertexAttribArray(1);
+    glVertexAttribIPointer(1, 2, GL_UNSIGNED_SHORT, stride, reinterpret_cast<void*>(offsetof(Instance, x)));
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_SHORT, stride, reinterpret_cast<void*>(offsetof(Instance, tile_id)));
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(3);
+    glVertexAttribIPointer(3, 1, GL_UNSIGNED_BYTE, stride, reinterpret_cast<void*>(offsetof(Instance, flags)));
+    glVertexAttribDivisor(3, 1);
+    glBindVertexArray(0);
+
+    result.count = static_cast<GLsizei>(instances.size());
+    result.tileset = {static_cast<float>(tile_size), static_cast<float>(tileset.spacing),
+                      static_cast<float>(tileset.padding), static_cast<float>(columns)};
+    result.valid = true;
+    m_instances_memory += instances.size() * sizeof(Instance);
+    return result;
+}
+
+bool InstancedRenderer::render(const LDtkProjectObjects::Layer& layer, const glm::vec2& level_pos) {
+    auto it = m_layers.find(&layer);
+    if (it == m_layers.end())
+        it = m_layers.emplace(&layer, build(layer)).first;
+    const auto& instances = it->second;
+    if (!instances.valid)
+        return false;
+
+    const auto& texture = TextureManager::get(layer.texture_path);
+    m_shader.bind();
+    m_shader.setUniform("texture_size", glm::vec2(texture.getSize()));
+    m_shader.setUniform("level_pos", level_pos);
+    m_shader.setUniform("tileset", instances.tileset);
+    m_shader.setUniform("opacity", layer.data.getOpacity());
+    texture.bind();
+    Profiler::countTextureBind();
+
+    glBindVertexArray(instances.vao);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instances.count);
+    Profiler::countDraw(static_cast<std::size_t>(instances.count) * 4);
+    glBindVertexArray(0);
+    return true;
+}
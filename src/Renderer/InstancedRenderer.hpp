@@ -0,0 +1,112 @@
+#pragma once
+
+#include "GL.hpp"
+#include "LDtkProject/LDtkProjectObjects.hpp"
+#include "LDtkProject/LevelCache.hpp"
+
+#include <sogl/Shader.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+
+// Draws tile layers with one compact record per tile, expanded from a static unit quad in the vertex shader.
+// The instances of a level are kept until the level is evicted from the cache.
+class InstancedRenderer : public LevelCache::Resource {
+public:
+    explicit InstancedRenderer(LevelCache& cache);
+    ~InstancedRenderer() override;
+    InstancedRenderer(const InstancedRenderer&) = delete;
+    InstancedRenderer& operator=(const InstancedRenderer&) = delete;
+
+    void begin(const glm::vec2& window_size, const glm::vec2& offset, const glm::vec3& transform);
+    void setColor(const glm::vec4& color);
+
+    // returns false when the layer tiles can't be expressed as instances, it must then be drawn by the layer itself
+    bool render(const LDtkProjectObjects::Layer& layer, const glm::vec2& level_pos);
+
+    // moves the instances of a layer to the same layer of a reloaded project
+    void transfer(const LDtkProjectObjects::Layer& from, const LDtkProjectObjects::Layer& to);
+    void invalidate(const LDtkProjectObjects::Layer& layer);
+    // forget the instances of a project's layers, must be called before its objects are destroyed
+    void clear();
+
+    std::size_t getMemory(const LDtkProjectObjects::Level& level) const override;
+    void release(const LDtkProjectObjects::Level& level) override;
+
+    std::size_t getInstancesMemory() const;
+
+private:
+    struct Instance {
+        std::uint16_t x;
+        std::uint16_t y;
+        std::uint16_t tile_id;
+        std::uint8_t flags;
+        std::uint8_t reserved;
+    };
+
+    struct LayerInstances {
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        GLsizei count = 0;
+        glm::vec4 tileset = {0, 0, 0, 0};
+        bool valid = false;
+    };
+
+    LayerInstances build(const LDtkProjectObjects::Layer& layer);
+
+    sogl::Shader m_shader;
+    GLuint m_quad_vbo = 0;
+    std::unordered_map<const LDtkProjectObjects::Layer*, LayerInstances> m_layers;
+    std::size_t m_instances_memory = 0;
+
+    static constexpr auto vert_shader = GLSL(330 core,
+        precision highp float;
+        uniform vec2 window_size;
+        uniform vec2 texture_size;
+        uniform vec3 transform;
+        uniform vec2 offset;
+        uniform vec2 level_pos;
+        // tile size, spacing, padding, columns count
+        uniform vec4 tileset;
+
+        layout (location = 0) in vec2 i_corner;
+        layout (location = 1) in uvec2 i_pos;
+        layout (location = 2) in uint i_tile;
+        layout (location = 3) in uint i_flags;
+
+        out vec2 tex;
+
+        void main() {
+            vec2 pos = level_pos + vec2(i_pos) + i_corner * tileset.x;
+            pos.xy /= window_size.xy;
+            pos.xy += transform.xy;
+            pos.xy *= 2.*transform.z;
+            pos.xy += offset.xy / window_size.xy;
+
+            uint columns = uint(tileset.w);
+            vec2 src = vec2(tileset.z) + vec2(float(i_tile % columns), float(i_tile / columns)) * (tileset.x + tileset.y);
+            vec2 corner = i_corner;
+            if ((i_flags & 1u) != 0u)
+                corner.x = 1. - corner.x;
+            if ((i_flags & 2u) != 0u)
+                corner.y = 1. - corner.y;
+            tex = (src + corner * tileset.x) / texture_size;
+
+            gl_Position = vec4(pos.x, -pos.y, 0, 1.0);
+        }
+    );
+    static constexpr auto frag_shader = GLSL(330 core,
+        precision highp float;
+        uniform sampler2D texture0;
+        uniform vec4 color;
+        uniform float opacity;
+
+        in vec2 tex;
+
+        out vec4 fragColor;
+
+        void main() {
+            fragColor = texture(texture0, tex) * vec4(1., 1., 1., opacity) * color;
+        }
+    );
+};
@@ -0,0 +1,190 @@
+#include "IntGridRenderer.hpp"
+#include "Profiler.hpp"
+
+#include "LDtkProject/ldtk2glm.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <vector>
+
+IntGridRenderer::IntGridRenderer(LevelCache& cache) : LevelCache::Resource(cache) {
+    m_shader.load(vert_shader, frag_shader);
+    m_shader.bind();
+    m_shader.setUniform("values", 0);
+    m_shader.setUniform("palette", 1);
+
+    const float corners[] = {0.f, 0.f, 1.f, 0.f, 0.f, 1.f, 1.f, 1.f};
+    glGenVertexArrays(1, &m_quad_vao);
+    glGenBuffers(1, &m_quad_vbo);
+    glBindVertexArray(m_quad_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_quad_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    glBindVertexArray(0);
+}
+
+IntGridRenderer::~IntGridRenderer() {
+    clear();
+    glDeleteBuffers(1, &m_quad_vbo);
+    glDeleteVertexArrays(1, &m_quad_vao);
+}
+
+void IntGridRenderer::clear() {
+    for (auto& [_, grid] : m_layers) {
+        glDeleteTextures(1, &grid.values);
+        glDeleteTextures(1, &grid.palette);
+    }
+    m_layers.clear();
+    m_textures_memory = 0;
+}
+
+void IntGridRenderer::transfer(const LDtkProjectObjects::Layer& from, const LDtkProjectObjects::Layer& to) {
+    auto node = m_layers.extract(&from);
+    if (node.empty())
+        return;
+    node.key() = &to;
+    m_layers.insert(std::move(node));
+}
+
+void IntGridRenderer::invalidate(const LDtkProjectObjects::Layer& layer) {
+    const auto it = m_layers.find(&layer);
+    if (it == m_layers.end())
+        return;
+    glDeleteTextures(1, &it->second.values);
+    glDeleteTextures(1, &it->second.palette);
+    m_textures_memory -= it->second.memory;
+    m_layers.erase(it);
+}
+
+std::size_t IntGridRenderer::getMemory(const LDtkProjectObjects::Level& level) const {
+    std::size_t memory = 0;
+    for (const auto& layer : level.layers) {
+        if (const auto it = m_layers.find(&layer); it != m_layers.end())
+            memory += it->second.memory;
+    }
+    return memory;
+}
+
+void IntGridRenderer::release(const LDtkProjectObjects::Level& level) {
+    for (const auto& layer : level.layers)
+        invalidate(layer);
+}
+
+std::size_t IntGridRenderer::getTexturesMemory() const {
+    return m_textures_memory;
+}
+
+bool IntGridRenderer::isPureIntGrid(const LDtkProjectObjects::Layer& layer) {
+    // IntGrid layers with auto-layer rules are drawn with their tiles
+    return layer.data.getType() == ldtk::LayerType::IntGrid && layer.data.allTiles().empty();
+}
+
+void IntGridRenderer::begin(const glm::vec2& window_size, const glm::vec2& offset, const glm::vec3& transform) {
+    m_shader.bind();
+    m_shader.setUniform("window_size", window_size);
+    m_shader.setUniform("offset", offset);
+    m_shader.setUniform("transform", transform);
+}
+
+void IntGridRenderer::setColor(const glm::vec4& color) {
+    m_shader.bind();
+    m_shader.setUniform("color", color);
+}
+
+auto IntGridRenderer::build(const LDtkProjectObjects::Layer& layer) -> LayerGrid {
+    LayerGrid result;
+    const auto& data = layer.data;
+    const auto grid_size = data.getGridSize();
+    if (grid_size.x <= 0 || grid_size.y <= 0)
+        return result;
+
+    // palette index 0 is kept for empty cells
+    std::map<int, std::uint16_t> indices;
+    std::vector<ldtk::Color> palette = {{0, 0, 0, 0}};
+    std::vector<std::uint16_t> cells(static_cast<std::size_t>(grid_size.x) * grid_size.y, 0);
+    for (int y = 0; y < grid_size.y; ++y) {
+        for (int x = 0; x < grid_size.x; ++x) {
+            const auto& value = data.getIntGridVal(x, y);
+            if (value.value <= 0)
+                continue;
+            auto it = indices.find(value.value);
+            if (it == indices.end()) {
+                if (palette.size() > std::numeric_limits<std::uint16_t>::max())
+                    return result;
+                it = indices.emplace(value.value, static_cast<std::uint16_t>(palette.size())).first;
+                palette.push_back(value.color);
+            }
+            cells[static_cast<std::size_t>(y) * grid_size.x + x] = it->second;
+        }
+    }
+    if (indices.empty())
+        return result;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // 8 bits cells unless the layer uses more than 255 different values
+    glGenTextures(1, &result.values);
+    glBindTexture(GL_TEXTURE_2D, result.values);
+    if (palette.size() <= 256) {
+        const std::vector<std::uint8_t> cells8(cells.begin(), cells.end());
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, grid_size.x, grid_size.y, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, cells8.data());
+        result.memory += cells8.size();
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, grid_size.x, grid_size.y, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, cells.data());
+        result.memory += cells.size() * sizeof(std::uint16_t);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    std::vector<std::uint8_t> colors;
+    colors.reserve(palette.size() * 4);
+    for (const auto& color : palette)
+        colors.insert(colors.end(), {color.r, color.g, color.b, color.a});
+    glGenTextures(1, &result.palette);
+    glBindTexture(GL_TEXTURE_2D, result.palette);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, static_cast<GLsizei>(palette.size()), 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, colors.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    result.memory += colors.size();
+    m_textures_memory += result.memory;
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    result.valid = true;
+    return result;
+}
+
+bool IntGridRenderer::render(const LDtkProjectObjects::Layer& layer) {
+    if (!isPureIntGrid(layer))
+        return false;
+
+    auto it = m_layers.find(&layer);
+    if (it == m_layers.end())
+        it = m_layers.emplace(&layer, build(layer)).first;
+    const auto& grid = it->second;
+    // layers without any value have nothing to draw
+    if (!grid.valid)
+        return true;
+
+    m_shader.bind();
+    m_shader.setUniform("layer_pos", layer.bounds.pos);
+    m_shader.setUniform("layer_size", layer.bounds.size);
+    m_shader.setUniform("grid_size", glm::vec2(ldtk2glm(layer.data.getGridSize())));
+    m_shader.setUniform("opacity", layer.data.getOpacity());
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, grid.palette);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, grid.values);
+    Profiler::countTextureBind();
+    Profiler::countTextureBind();
+
+    glBindVertexArray(m_quad_vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    Profiler::countDraw(4);
+    glBindVertexArray(0);
+    return true;
+}
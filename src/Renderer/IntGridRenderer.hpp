@@ -0,0 +1,99 @@
+#pragma once
+
+#include "GL.hpp"
+#include "LDtkProject/LDtkProjectObjects.hpp"
+#include "LDtkProject/LevelCache.hpp"
+
+#include <sogl/Shader.hpp>
+
+#include <unordered_map>
+
+// Draws IntGrid layers without tiles as a single quad, the cells values being stored in an integer texture
+// and turned into colors with a palette texture in the fragment shader.
+// The textures of a level are kept until the level is evicted from the cache.
+class IntGridRenderer : public LevelCache::Resource {
+public:
+    explicit IntGridRenderer(LevelCache& cache);
+    ~IntGridRenderer() override;
+    IntGridRenderer(const IntGridRenderer&) = delete;
+    IntGridRenderer& operator=(const IntGridRenderer&) = delete;
+
+    static bool isPureIntGrid(const LDtkProjectObjects::Layer& layer);
+
+    void begin(const glm::vec2& window_size, const glm::vec2& offset, const glm::vec3& transform);
+    void setColor(const glm::vec4& color);
+
+    // returns false when the layer is not a pure IntGrid layer
+    bool render(const LDtkProjectObjects::Layer& layer);
+
+    // moves the textures of a layer to the same layer of a reloaded project
+    void transfer(const LDtkProjectObjects::Layer& from, const LDtkProjectObjects::Layer& to);
+    void invalidate(const LDtkProjectObjects::Layer& layer);
+    void clear();
+
+    std::size_t getMemory(const LDtkProjectObjects::Level& level) const override;
+    void release(const LDtkProjectObjects::Level& level) override;
+
+    std::size_t getTexturesMemory() const;
+
+private:
+    struct LayerGrid {
+        GLuint values = 0;
+        GLuint palette = 0;
+        std::size_t memory = 0;
+        bool valid = false;
+    };
+
+    LayerGrid build(const LDtkProjectObjects::Layer& layer);
+
+    sogl::Shader m_shader;
+    GLuint m_quad_vao = 0;
+    GLuint m_quad_vbo = 0;
+    std::unordered_map<const LDtkProjectObjects::Layer*, LayerGrid> m_layers;
+    std::size_t m_textures_memory = 0;
+
+    static constexpr auto vert_shader = GLSL(330 core,
+        precision highp float;
+        uniform vec2 window_size;
+        uniform vec3 transform;
+        uniform vec2 offset;
+        uniform vec2 layer_pos;
+        uniform vec2 layer_size;
+        uniform vec2 grid_size;
+
+        layout (location = 0) in vec2 i_corner;
+
+        out vec2 cell;
+
+        void main() {
+            vec2 pos = layer_pos + i_corner * layer_size;
+            pos.xy /= window_size.xy;
+            pos.xy += transform.xy;
+            pos.xy *= 2.*transform.z;
+            pos.xy += offset.xy / window_size.xy;
+
+            cell = i_corner * grid_size;
+
+            gl_Position = vec4(pos.x, -pos.y, 0, 1.0);
+        }
+    );
+    static constexpr auto frag_shader = GLSL(330 core,
+        precision highp float;
+        precision highp usampler2D;
+        uniform usampler2D values;
+        uniform sampler2D palette;
+        uniform vec4 color;
+        uniform float opacity;
+
+        in vec2 cell;
+
+        out vec4 fragColor;
+
+        void main() {
+            uint index = texelFetch(values, ivec2(cell), 0).r;
+            if (index == 0u)
+                discard;
+            fragColor = texelFetch(palette, ivec2(int(index), 0), 0) * vec4(1., 1., 1., opacity) * color;
+        }
+    );
+};
@@ -0,0 +1,134 @@
+#include "TextureAtlas.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+
+// empty pixels between packed images, avoids bleeding when sampling at the edges
+constexpr auto padding = 1;
+constexpr auto max_page_size = 4096;
+
+TextureAtlas::~TextureAtlas() {
+    clear();
+}
+
+void TextureAtlas::build(const std::vector<TextureManager::Handle>& textures) {
+    clear();
+
+    GLint gl_max_size = max_page_size;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &gl_max_size);
+    const auto page_size = std::min(max_page_size, static_cast<int>(gl_max_size));
+
+    std::vector<glm::vec<2, int>> sizes(textures.size());
+    for (std::size_t i = 0; i < textures.size(); ++i)
+        sizes[i] = textures[i].getTexture().getSize();
+
+    // shelf packing, tallest images first
+    std::vector<std::size_t> order(textures.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](auto a, auto b) { return sizes[a].y > sizes[b].y; });
+
+    auto shared_page = -1;
+    glm::vec<2, int> cursor = {0, 0};
+    auto shelf_height = 0;
+    for (auto i : order) {
+        const auto& size = sizes[i];
+        const auto& name = textures[i].getName();
+        if (size.x <= 0 || size.y <= 0 || m_regions.count(name) > 0)
+            continue;
+        if (size.x > gl_max_size || size.y > gl_max_size) {
+            std::cerr << "Texture " << name << " is too big for the atlas (" << size.x << "x" << size.y << ")" << std::endl;
+            continue;
+        }
+        if (size.x + padding > page_size || size.y + padding > page_size) {
+            // too big to share a page
+            m_regions[name] = {static_cast<int>(m_pages.size()), {0, 0}};
+            m_pages.push_back({0, size});
+            continue;
+        }
+        if (cursor.x + size.x > page_size) {
+            cursor = {0, cursor.y + shelf_height};
+            shelf_height = 0;
+        }
+        if (shared_page < 0 || cursor.y + size.y > page_size) {
+            shared_page = static_cast<int>(m_pages.size());
+            m_pages.push_back({0, {0, 0}});
+            cursor = {0, 0};
+            shelf_height = 0;
+        }
+        auto& page_size_used = m_pages[shared_page].size;
+        m_regions[name] = {shared_page, glm::vec2(cursor)};
+        page_size_used.x = std::max(page_size_used.x, cursor.x + size.x);
+        page_size_used.y = std::max(page_size_used.y, cursor.y + size.y);
+        cursor.x += size.x + padding;
+        shelf_height = std::max(shelf_height, size.y + padding);
+    }
+
+    for (auto& page : m_pages) {
+        glGenTextures(1, &page.texture);
+        glBindTexture(GL_TEXTURE_2D, page.texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, page.size.x, page.size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    // each texture is attached to a framebuffer and copied into its page
+    GLuint framebuffer = 0;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    for (std::size_t i = 0; i < textures.size(); ++i) {
+        const auto it = m_regions.find(textures[i].getName());
+        if (it == m_regions.end())
+            continue;
+        GLint source = 0;
+        textures[i].getTexture().bind();
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &source);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, static_cast<GLuint>(source), 0);
+        if (glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Failed to copy " << textures[i].getName() << " to the atlas" << std::endl;
+            m_regions.erase(it);
+            continue;
+        }
+        const auto& region = it->second;
+        glBindTexture(GL_TEXTURE_2D, m_pages[region.page].texture);
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(region.offset.x), static_cast<GLint>(region.offset.y),
+                            0, 0, sizes[i].x, sizes[i].y);
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void TextureAtlas::clear() {
+    for (auto& page : m_pages)
+        glDeleteTextures(1, &page.texture);
+    m_pages.clear();
+    m_regions.clear();
+}
+
+auto TextureAtlas::getRegion(const std::string& name) const -> const Region* {
+    const auto it = m_regions.find(name);
+    return it == m_regions.end() ? nullptr : &it->second;
+}
+
+void TextureAtlas::bindPage(int index) const {
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_pages.at(static_cast<std::size_t>(index)).texture);
+}
+
+glm::vec2 TextureAtlas::getPageSize(int index) const {
+    return glm::vec2(m_pages.at(static_cast<std::size_t>(index)).size);
+}
+
+std::size_t TextureAtlas::getPagesCount() const {
+    return m_pages.size();
+}
+
+std::size_t TextureAtlas::getMemory() const {
+    std::size_t memory = 0;
+    for (const auto& page : m_pages)
+        memory += static_cast<std::size_t>(page.size.x) * page.size.y * 4;
+    return memory;
+}
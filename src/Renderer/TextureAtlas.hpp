@@ -0,0 +1,43 @@
+#pragma once
+
+#include "GL.hpp"
+#include "TextureManager.hpp"
+
+#include <glm/glm.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Packs several textures into as few textures (pages) as possible.
+// The textures are copied on the GPU, their images are not decoded again.
+class TextureAtlas {
+public:
+    struct Region {
+        int page = 0;
+        glm::vec2 offset = {0, 0};
+    };
+
+    TextureAtlas() = default;
+    ~TextureAtlas();
+    TextureAtlas(const TextureAtlas&) = delete;
+    TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+    void build(const std::vector<TextureManager::Handle>& textures);
+    void clear();
+
+    const Region* getRegion(const std::string& name) const;
+    void bindPage(int index) const;
+    glm::vec2 getPageSize(int index) const;
+    std::size_t getPagesCount() const;
+    std::size_t getMemory() const;
+
+private:
+    struct Page {
+        GLuint texture = 0;
+        glm::vec<2, int> size = {0, 0};
+    };
+
+    std::map<std::string, Region> m_regions;
+    std::vector<Page> m_pages;
+};
@@ -0,0 +1,209 @@
+#include "TilemapRenderer.hpp"
+#include "Profiler.hpp"
+
+#include "LDtkProject/ldtk2glm.hpp"
+#include "TextureManager.hpp"
+
+#include <algorithm>
+#include <limits>
+
+TilemapRenderer::TilemapRenderer(LevelCache& cache) : LevelCache::Resource(cache) {
+    m_shader.load(vert_shader, frag_shader);
+    m_shader.bind();
+    m_shader.setUniform("texture0", 0);
+    m_shader.setUniform("tilemap", 1);
+
+    const float corners[] = {0.f, 0.f, 1.f, 0.f, 0.f, 1.f, 1.f, 1.f};
+    glGenVertexArrays(1, &m_quad_vao);
+    glGenBuffers(1, &m_quad_vbo);
+    glBindVertexArray(m_quad_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_quad_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    glBindVertexArray(0);
+}
+
+TilemapRenderer::~TilemapRenderer() {
+    clear();
+    glDeleteBuffers(1, &m_quad_vbo);
+    glDeleteVertexArrays(1, &m_quad_vao);
+}
+
+void TilemapRenderer::clear() {
+    for (auto& [_, tilemap] : m_layers)
+        glDeleteTextures(1, &tilemap.texture);
+    m_layers.clear();
+    m_tilemaps_memory = 0;
+}
+
+std::size_t TilemapRenderer::getMemory(const LDtkProjectObjects::Level& level) const {
+    std::size_t memory = 0;
+    for (const auto& layer : level.layers) {
+        const auto it = m_layers.find(&layer);
+        if (it != m_layers.end() && it->second.texture != 0)
+            memory += static_cast<std::size_t>(it->second.grid_size.x) * it->second.grid_size.y * sizeof(Cell);
+    }
+    return memory;
+}
+
+void TilemapRenderer::release(const LDtkProjectObjects::Level& level) {
+    for (const auto& layer : level.layers)
+        invalidate(layer);
+}
+
+std::size_t TilemapRenderer::getTilemapsMemory() const {
+    return m_tilemaps_memory;
+}
+
+void TilemapRenderer::begin(const glm::vec2& window_size, const glm::vec2& offset, const glm::vec3& transform) {
+    m_shader.bind();
+    m_shader.setUniform("window_size", window_size);
+    m_shader.setUniform("offset", offset);
+    m_shader.setUniform("transform", transform);
+}
+
+void TilemapRenderer::setColor(const glm::vec4& color) {
+    m_shader.bind();
+    m_shader.setUniform("color", color);
+}
+
+bool TilemapRenderer::buildCells(const LDtkProjectObjects::Layer& layer, LayerTilemap& tilemap) {
+    const auto& data = layer.data;
+    if (data.allTiles().empty() || layer.texture_path.empty())
+        return false;
+    const auto& texture = TextureManager::get(layer.texture_path);
+
+    const auto& tileset = data.getTileset();
+    const auto tile_size = tileset.tile_size;
+    const auto cell_size = data.getCellSize();
+    const auto columns = (texture.getSize().x - tileset.padding * 2 + tileset.spacing) / (tile_size + tileset.spacing);
+    if (tile_size <= 0 || columns <= 0 || tile_size != cell_size)
+        return false;
+
+    const auto grid_size = ldtk2glm(data.getGridSize());
+    const auto layer_offset = glm::vec2(ldtk2glm(data.getOffset()));
+    constexpr auto max_tile = static_cast<int>(std::numeric_limits<std::uint16_t>::max()) - 1;
+
+    m_cells.assign(static_cast<std::size_t>(grid_size.x) * grid_size.y, {0, 0});
+    for (const auto& tile : data.allTiles()) {
+        if (tile.getPosition().x < 0 || tile.getPosition().x > grid_size.x * cell_size
+            || tile.getPosition().y < 0 || tile.getPosition().y > grid_size.y * cell_size)
+            continue;
+        const auto verts = tile.getVertices();
+        auto pos = glm::vec2(ldtk2glm(verts[0].pos));
+        auto tex = glm::vec<2, int>(ldtk2glm(verts[0].tex));
+        for (const auto& v : verts) {
+            pos = glm::min(pos, glm::vec2(ldtk2glm(v.pos)));
+            tex = glm::min(tex, ldtk2glm(v.tex));
+        }
+        pos -= layer_offset;
+
+        // the tile must fill exactly one cell, and its texture position must match the one computed from its id
+        const auto cell = glm::vec<2, int>(pos) / cell_size;
+        const auto expected_x = tileset.padding + (tile.tileId % columns) * (tile_size + tileset.spacing);
+        const auto expected_y = tileset.padding + (tile.tileId / columns) * (tile_size + tileset.spacing);
+        if (tex.x != expected_x || tex.y != expected_y || tile.tileId < 0 || tile.tileId > max_tile
+            || pos.x != static_cast<float>(cell.x * cell_size) || pos.y != static_cast<float>(cell.y * cell_size)
+            || cell.x < 0 || cell.y < 0 || cell.x >= grid_size.x || cell.y >= grid_size.y)
+            return false;
+
+        // stacked tiles can't be expressed with one value per cell
+        auto& value = m_cells[static_cast<std::size_t>(cell.y) * grid_size.x + cell.x];
+        if (value.tile != 0)
+            return false;
+        value.tile = static_cast<std::uint16_t>(tile.tileId + 1);
+        value.flags = static_cast<std::uint16_t>((tile.flipX ? 1 : 0) | (tile.flipY ? 2 : 0));
+    }
+
+    tilemap.grid_size = grid_size;
+    tilemap.tileset = {static_cast<float>(tile_size), static_cast<float>(tileset.spacing),
+                       static_cast<float>(tileset.padding), static_cast<float>(columns)};
+    return true;
+}
+
+void TilemapRenderer::upload(LayerTilemap& tilemap) {
+    if (tilemap.texture == 0) {
+        glGenTextures(1, &tilemap.texture);
+        glBindTexture(GL_TEXTURE_2D, tilemap.texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16UI, tilemap.grid_size.x, tilemap.grid_size.y, 0,
+                     GL_RG_INTEGER, GL_UNSIGNED_SHORT, m_cells.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        m_tilemaps_memory += m_cells.size() * sizeof(Cell);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, tilemap.texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tilemap.grid_size.x, tilemap.grid_size.y,
+                        GL_RG_INTEGER, GL_UNSIGNED_SHORT, m_cells.data());
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    tilemap.valid = true;
+}
+
+void TilemapRenderer::update(const LDtkProjectObjects::Layer& layer) {
+    auto it = m_layers.find(&layer);
+    if (it == m_layers.end())
+        return;
+    auto& tilemap = it->second;
+    const auto previous_size = tilemap.grid_size;
+    if (!buildCells(layer, tilemap) || tilemap.grid_size != previous_size) {
+        if (tilemap.texture != 0) {
+            glDeleteTextures(1, &tilemap.texture);
+            m_tilemaps_memory -= static_cast<std::size_t>(previous_size.x) * previous_size.y * sizeof(Cell);
+        }
+        m_layers.erase(it);
+        return;
+    }
+    upload(tilemap);
+}
+
+void TilemapRenderer::transfer(const LDtkProjectObjects::Layer& from, const LDtkProjectObjects::Layer& to) {
+    auto node = m_layers.extract(&from);
+    if (node.empty())
+        return;
+    node.key() = &to;
+    m_layers.insert(std::move(node));
+}
+
+void TilemapRenderer::invalidate(const LDtkProjectObjects::Layer& layer) {
+    const auto it = m_layers.find(&layer);
+    if (it == m_layers.end())
+        return;
+    if (it->second.texture != 0) {
+        glDeleteTextures(1, &it->second.texture);
+        m_tilemaps_memory -= static_cast<std::size_t>(it->second.grid_size.x) * it->second.grid_size.y * sizeof(Cell);
+    }
+    m_layers.erase(it);
+}
+
+bool TilemapRenderer::render(const LDtkProjectObjects::Layer& layer) {
+    auto it = m_layers.find(&layer);
+    if (it == m_layers.end()) {
+        it = m_layers.emplace(&layer, LayerTilemap()).first;
+        if (buildCells(layer, it->second))
+            upload(it->second);
+    }
+    const auto& tilemap = it->second;
+    if (!tilemap.valid)
+        return false;
+
+    const auto& texture = TextureManager::get(layer.texture_path);
+    m_shader.bind();
+    m_shader.setUniform("layer_pos", layer.bounds.pos);
+    m_shader.setUniform("layer_size", layer.bounds.size);
+    m_shader.setUniform("tileset", tilemap.tileset);
+    m_shader.setUniform("opacity", layer.data.getOpacity());
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, tilemap.texture);
+    glActiveTexture(GL_TEXTURE0);
+    texture.bind();
+    Profiler::countTextureBind();
+    Profiler::countTextureBind();
+
+    glBindVertexArray(m_quad_vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    Profiler::countDraw(4);
+    glBindVertexArray(0);
+    return true;
+}
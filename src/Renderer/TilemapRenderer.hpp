@@ -0,0 +1,123 @@
+#pragma once
+
+#include "GL.hpp"
+#include "LDtkProject/LDtkProjectObjects.hpp"
+#include "LDtkProject/LevelCache.hpp"
+
+#include <sogl/Shader.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Draws tile layers as a single quad, the tile id and flip flags of each cell being stored in an integer texture
+// from which the fragment shader computes the tileset texel to fetch.
+// Only layers with at most one grid-aligned tile per cell can be drawn this way.
+// The tilemaps of a level are kept until the level is evicted from the cache.
+class TilemapRenderer : public LevelCache::Resource {
+public:
+    explicit TilemapRenderer(LevelCache& cache);
+    ~TilemapRenderer() override;
+    TilemapRenderer(const TilemapRenderer&) = delete;
+    TilemapRenderer& operator=(const TilemapRenderer&) = delete;
+
+    void begin(const glm::vec2& window_size, const glm::vec2& offset, const glm::vec3& transform);
+    void setColor(const glm::vec4& color);
+
+    // returns false when the layer tiles can't be expressed as a tilemap, it must then be drawn by the layer itself
+    bool render(const LDtkProjectObjects::Layer& layer);
+    // rebuilds the tilemap of a layer whose tiles changed, with a sub-upload when its grid size is the same
+    void update(const LDtkProjectObjects::Layer& layer);
+    // moves the tilemap of a layer to the same layer of a reloaded project
+    void transfer(const LDtkProjectObjects::Layer& from, const LDtkProjectObjects::Layer& to);
+    void invalidate(const LDtkProjectObjects::Layer& layer);
+
+    void clear();
+
+    std::size_t getMemory(const LDtkProjectObjects::Level& level) const override;
+    void release(const LDtkProjectObjects::Level& level) override;
+
+    std::size_t getTilemapsMemory() const;
+
+private:
+    struct Cell {
+        // tile id + 1, 0 for empty cells
+        std::uint16_t tile;
+        std::uint16_t flags;
+    };
+
+    struct LayerTilemap {
+        GLuint texture = 0;
+        glm::vec<2, int> grid_size = {0, 0};
+        // tile size, spacing, padding, columns count
+        glm::vec4 tileset = {0, 0, 0, 0};
+        bool valid = false;
+    };
+
+    bool buildCells(const LDtkProjectObjects::Layer& layer, LayerTilemap& tilemap);
+    void upload(LayerTilemap& tilemap);
+
+    sogl::Shader m_shader;
+    GLuint m_quad_vao = 0;
+    GLuint m_quad_vbo = 0;
+    std::unordered_map<const LDtkProjectObjects::Layer*, LayerTilemap> m_layers;
+    std::vector<Cell> m_cells;
+    std::size_t m_tilemaps_memory = 0;
+
+    static constexpr auto vert_shader = GLSL(330 core,
+        precision highp float;
+        uniform vec2 window_size;
+        uniform vec3 transform;
+        uniform vec2 offset;
+        uniform vec2 layer_pos;
+        uniform vec2 layer_size;
+
+        layout (location = 0) in vec2 i_corner;
+
+        out vec2 local;
+
+        void main() {
+            local = i_corner * layer_size;
+            vec2 pos = layer_pos + local;
+            pos.xy /= window_size.xy;
+            pos.xy += transform.xy;
+            pos.xy *= 2.*transform.z;
+            pos.xy += offset.xy / window_size.xy;
+
+            gl_Position = vec4(pos.x, -pos.y, 0, 1.0);
+        }
+    );
+    static constexpr auto frag_shader = GLSL(330 core,
+        precision highp float;
+        precision highp usampler2D;
+        uniform usampler2D tilemap;
+        uniform sampler2D texture0;
+        // tile size, spacing, padding, columns count
+        uniform vec4 tileset;
+        uniform vec4 color;
+        uniform float opacity;
+
+        in vec2 local;
+
+        out vec4 fragColor;
+
+        void main() {
+            vec2 cell = floor(local / tileset.x);
+            uvec2 value = texelFetch(tilemap, ivec2(cell), 0).rg;
+            if (value.r == 0u)
+                discard;
+            uint tile = value.r - 1u;
+            uint columns = uint(tileset.w);
+
+            vec2 in_tile = local - cell * tileset.x;
+            if ((value.g & 1u) != 0u)
+                in_tile.x = tileset.x - in_tile.x;
+            if ((value.g & 2u) != 0u)
+                in_tile.y = tileset.x - in_tile.y;
+            in_tile = clamp(in_tile, vec2(0.), vec2(tileset.x - 0.5));
+
+            vec2 src = vec2(tileset.z) + vec2(float(tile % columns), float(tile / columns)) * (tileset.x + tileset.y);
+            fragColor = texelFetch(texture0, ivec2(src + in_tile), 0) * vec4(1., 1., 1., opacity) * color;
+        }
+    );
+};
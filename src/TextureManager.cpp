@@ -1,38 +1,177 @@
 // Created by Modar Nasser on 06/03/2022.
 
 #include "TextureManager.hpp"
+#include "Image.hpp"
+#include "ThreadPool.hpp"
 
-#define CUTE_ASEPRITE_IMPLEMENTATION
-#include "thirdparty/cute_aseprite.h"
-
+#include <atomic>
 #include <iostream>
 #include <filesystem>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace {
+    std::size_t memoryOf(const sogl::Texture& texture) {
+        const auto size = texture.getSize();
+        return static_cast<std::size_t>(size.x) * static_cast<std::size_t>(size.y) * 4;
+    }
+}
 
 TextureManager& TextureManager::instance() {
     static TextureManager instance;
     return instance;
 }
 
+auto TextureManager::entry(const std::string& name) -> Entry& {
+    auto& manager = instance();
+    auto [it, inserted] = manager.data.try_emplace(name);
+    if (inserted)
+        it->second.name = name;
+    it->second.last_use = ++manager.clock;
+    return it->second;
+}
+
 sogl::Texture& TextureManager::get(const std::string& name) {
-    auto& data = instance().data;
-    if (data.count(name) == 0) {
-        auto path = std::filesystem::path(name);
-        if (path.extension() == ".aseprite") {
-            auto* ase = cute_aseprite_load_from_file(name.c_str(), nullptr);
-            auto& frame = ase->frames[0];
-            if (!data[name].load(reinterpret_cast<std::uint8_t*>(frame.pixels), ase->w, ase->h, 4))
-                std::cerr << "Failed to load Texture " << name << std::endl;
-            cute_aseprite_free(ase);
+    auto& manager = instance();
+    if (const auto it = manager.data.find(name); it != manager.data.end()) {
+        it->second.last_use = ++manager.clock;
+        return it->second.texture;
+    }
+
+    auto& loaded = entry(name);
+    auto path = std::filesystem::path(name);
+    if (path.extension() == ".aseprite") {
+        Image image;
+        if (!image.load(name) || !loaded.texture.load(image.pixels.data(), image.width, image.height, 4))
+            std::cerr << "Failed to load Texture " << name << std::endl;
+    }
+    else {
+        if (!loaded.texture.load(name))
+            std::cerr << "Failed to load Texture " << name << std::endl;
+    }
+    loaded.memory = memoryOf(loaded.texture);
+    manager.memory += loaded.memory;
+    return loaded.texture;
+}
+
+void TextureManager::prefetch(std::map<std::string, Image>& images, ThreadPool& pool,
+                              const std::function<void(std::size_t)>& on_decoded) {
+    std::vector<std::pair<const std::string, Image>*> entries;
+    entries.reserve(images.size());
+    for (auto& entry : images)
+        entries.push_back(&entry);
+
+    std::atomic<std::size_t> decoded = 0;
+    std::mutex errors_mutex;
+    pool.parallelFor(entries.size(), [&](std::size_t index) {
+        auto& [path, image] = *entries[index];
+        if (!image.load(path)) {
+            std::lock_guard lock(errors_mutex);
+            std::cerr << "Failed to load Image " << path << std::endl;
         }
-        else {
-            if (!data[name].load(name))
-                std::cerr << "Failed to load Texture " << name << std::endl;
+        const auto count = ++decoded;
+        if (on_decoded)
+            on_decoded(count);
+    });
+}
+
+auto TextureManager::load(const std::string& name, const Image& image) -> Handle {
+    auto& manager = instance();
+    auto& loaded = entry(name);
+    // reloaded projects come with freshly decoded images, the previous content may be stale
+    if (image.pixels.empty() || !loaded.texture.load(image.pixels.data(), image.width, image.height, 4))
+        std::cerr << "Failed to load Texture " << name << std::endl;
+    manager.memory -= loaded.memory;
+    loaded.memory = memoryOf(loaded.texture);
+    manager.memory += loaded.memory;
+    return Handle(&loaded);
+}
+
+void TextureManager::trim() {
+    auto& manager = instance();
+    while (manager.memory > manager.budget) {
+        auto oldest = manager.data.end();
+        for (auto it = manager.data.begin(); it != manager.data.end(); ++it) {
+            if (it->second.references == 0 && (oldest == manager.data.end() || it->second.last_use < oldest->second.last_use))
+                oldest = it;
         }
+        if (oldest == manager.data.end())
+            break;
+        manager.memory -= oldest->second.memory;
+        manager.data.erase(oldest);
     }
-
-    return instance().data.at(name);
 }
 
 void TextureManager::clear() {
-    instance().data.clear();
+    // textures with handles are still in use
+    auto& manager = instance();
+    for (auto it = manager.data.begin(); it != manager.data.end();) {
+        if (it->second.references == 0) {
+            manager.memory -= it->second.memory;
+            it = manager.data.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TextureManager::setBudget(std::size_t bytes) {
+    instance().budget = bytes;
+}
+
+std::size_t TextureManager::getBudget() {
+    return instance().budget;
+}
+
+std::size_t TextureManager::getMemory() {
+    return instance().memory;
+}
+
+std::size_t TextureManager::getUnusedMemory() {
+    std::size_t memory = 0;
+    for (const auto& [_, entry] : instance().data) {
+        if (entry.references == 0)
+            memory += entry.memory;
+    }
+    return memory;
+}
+
+std::size_t TextureManager::getCount() {
+    return instance().data.size();
+}
+
+TextureManager::Handle::Handle(Entry* entry) : m_entry(entry) {
+    m_entry->references++;
+}
+
+TextureManager::Handle::Handle(const Handle& other) : m_entry(other.m_entry) {
+    if (m_entry != nullptr)
+        m_entry->references++;
+}
+
+TextureManager::Handle::Handle(Handle&& other) noexcept : m_entry(std::exchange(other.m_entry, nullptr))
+{}
+
+auto TextureManager::Handle::operator=(Handle other) noexcept -> Handle& {
+    std::swap(m_entry, other.m_entry);
+    return *this;
+}
+
+TextureManager::Handle::~Handle() {
+    // the texture stays loaded, it becomes the most recently released one
+    if (m_entry != nullptr && --m_entry->references == 0)
+        m_entry->last_use = ++instance().clock;
+}
+
+sogl::Texture& TextureManager::Handle::getTexture() const {
+    return m_entry->texture;
+}
+
+std::size_t TextureManager::Handle::getMemory() const {
+    return m_entry != nullptr ? m_entry->memory : 0;
+}
+
+const std::string& TextureManager::Handle::getName() const {
+    return m_entry->name;
 }
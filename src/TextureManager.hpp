@@ -4,16 +4,72 @@
 
 #include <sogl/Texture.hpp>
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <map>
+#include <string>
 
+struct Image;
+class ThreadPool;
+
+// Textures are shared by name. Projects keep a Handle on each texture they use, textures without handles
+// stay loaded for a later use until the memory taken by all the textures exceeds the budget.
 class TextureManager {
+    struct Entry;
 public:
+    // reference on a texture, which stays loaded as long as a handle on it exists
+    class Handle {
+    public:
+        Handle() = default;
+        Handle(const Handle& other);
+        Handle(Handle&& other) noexcept;
+        Handle& operator=(Handle other) noexcept;
+        ~Handle();
+
+        explicit operator bool() const { return m_entry != nullptr; }
+        sogl::Texture& getTexture() const;
+        std::size_t getMemory() const;
+        const std::string& getName() const;
+    private:
+        friend class TextureManager;
+        explicit Handle(Entry* entry);
+        Entry* m_entry = nullptr;
+    };
+
     TextureManager(const TextureManager&) = delete;
     TextureManager(TextureManager&&) = delete;
+    // loads the texture from its file if needed, without taking a reference on it
     static sogl::Texture& get(const std::string& name);
+    // decodes the images of the map keys in parallel, any thread, so that they can be uploaded with load()
+    // on_decoded is called from the pool threads with the count of images decoded so far
+    static void prefetch(std::map<std::string, Image>& images, ThreadPool& pool,
+                         const std::function<void(std::size_t)>& on_decoded = {});
+    // uploads an already decoded image, replacing the content of a texture with the same name
+    static Handle load(const std::string& name, const Image& image);
+    // unloads the least recently released textures without handles, while over the budget
+    static void trim();
     static void clear();
+
+    static void setBudget(std::size_t bytes);
+    static std::size_t getBudget();
+    static std::size_t getMemory();
+    // memory of the textures without handles
+    static std::size_t getUnusedMemory();
+    static std::size_t getCount();
 private:
+    struct Entry {
+        sogl::Texture texture;
+        std::string name;
+        std::size_t memory = 0;
+        int references = 0;
+        std::uint64_t last_use = 0;
+    };
     TextureManager() = default;
     static TextureManager& instance();
-    std::map<std::string, sogl::Texture> data;
+    static Entry& entry(const std::string& name);
+    std::map<std::string, Entry> data;
+    std::size_t budget = std::size_t(512) * 1024 * 1024;
+    std::size_t memory = 0;
+    std::uint64_t clock = 0;
 };
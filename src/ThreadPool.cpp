@@ -0,0 +1,106 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+ThreadPool::ThreadPool(unsigned threads_count) {
+    m_threads.reserve(threads_count);
+    for (unsigned i = 0; i < threads_count; ++i)
+        m_threads.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+ThreadPool& ThreadPool::global() {
+#if defined(EMSCRIPTEN)
+    static ThreadPool pool(0);
+#else
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+#endif
+    return pool;
+}
+
+unsigned ThreadPool::getThreadsCount() const {
+    return static_cast<unsigned>(m_threads.size());
+}
+
+void ThreadPool::push(std::function<void()> task) {
+    if (m_threads.empty()) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_condition.notify_one();
+}
+
+void ThreadPool::work() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+            if (m_stop && m_tasks.empty())
+                return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& fn) {
+    if (count == 0)
+        return;
+
+    // shared with the helper tasks, which may start after this call returned
+    struct State {
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> done{0};
+        std::size_t count = 0;
+        const std::function<void(std::size_t)>* fn = nullptr;
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+    state->count = count;
+    state->fn = &fn;
+
+    auto run = [](State& s) {
+        for (auto i = s.next++; i < s.count; i = s.next++) {
+            try {
+                (*s.fn)(i);
+            } catch (...) {
+                std::lock_guard lock(s.mutex);
+                if (!s.error)
+                    s.error = std::current_exception();
+            }
+            if (++s.done == s.count) {
+                std::lock_guard lock(s.mutex);
+                s.finished.notify_all();
+            }
+        }
+    };
+
+    const auto helpers = std::min<std::size_t>(m_threads.size(), count - 1);
+    for (std::size_t i = 0; i < helpers; ++i)
+        push([state, run] { run(*state); });
+    run(*state);
+
+    std::unique_lock lock(state->mutex);
+    state->finished.wait(lock, [&] { return state->done == state->count; });
+    if (state->error)
+        std::rethrow_exception(state->error);
+}
@@ -1,6 +1,32 @@
 #include "App.hpp"
+#include "Exporter.hpp"
+#include "ThreadPool.hpp"
 
-int main() {
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+int main(int argc, char** argv) {
+#if !defined(EMSCRIPTEN)
+    // headless mode, the levels are rendered on the CPU so that no GPU nor display is needed
+    if (argc > 1 && std::strcmp(argv[1], "--export") == 0) {
+        if (argc != 4) {
+            std::cerr << "Usage: " << argv[0] << " --export <directory> <project.ldtk>" << std::endl;
+            return 1;
+        }
+        auto& pool = ThreadPool::global();
+        Exporter::Stats stats;
+        const auto success = Exporter::exportProject(argv[3], argv[2], pool, stats);
+        if (stats.levels > 0) {
+            const auto seconds = stats.render_ms / 1000.;
+            std::cout << "Exported " << stats.levels - stats.failed << "/" << stats.levels << " levels to " << argv[2]
+                      << " in " << stats.render_ms << " ms (" << static_cast<double>(stats.levels) / std::max(seconds, 1e-6)
+                      << " levels/s on " << std::max(1u, pool.getThreadsCount()) << " threads, loading "
+                      << stats.load_ms << " ms)" << std::endl;
+        }
+        return success ? 0 : 1;
+    }
+#endif
     App app;
     app.run();
     return 0;